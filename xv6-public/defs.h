@@ -1,11 +1,19 @@
 struct buf;
 struct context;
+struct cpu;
 struct file;
 struct inode;
 struct pipe;
 struct proc;
 struct rtcdate;
+struct schedparam;
+struct procstat;
+struct procinfo;
+struct cpustat;
+struct latstat;
+struct lockstat;
 struct spinlock;
+struct sleeplock;
 struct stat;
 struct superblock;
 struct queue;
@@ -42,6 +50,7 @@ struct inode*   ialloc(uint, short);
 struct inode*   idup(struct inode*);
 void            iinit(int dev);
 void            ilock(struct inode*);
+void            ilockshared(struct inode*);
 void            iput(struct inode*);
 void            iunlock(struct inode*);
 void            iunlockput(struct inode*);
@@ -78,6 +87,7 @@ int             cpunum(void);
 extern volatile uint*    lapic;
 void            lapiceoi(void);
 void            lapicinit(void);
+void            lapicipi(uchar, int);
 void            lapicstartap(uchar, uint);
 void            microdelay(int);
 
@@ -118,22 +128,49 @@ void            sleep(void*, struct spinlock*);
 void            userinit(void);
 int             wait(void);
 int		waitstat(int *, int*);
+int             waitstat2(struct procstat*);
+int             getprocstat(int, struct procstat*);
+int             getprocs(struct procinfo*, int);
+int             getcpustat(struct cpustat*, int);
+int             setaffinity(int, uint);
+int             schedtick(struct proc*);
+int             setrt(int, int, int);
+void            rtwakeup(void);
+int             rtpreempt(struct proc*);
+int             setpriority(int, int);
+int             getpriority(int);
+int             inheritprio(struct proc*);
+void            disinherit(void);
+int             getlatency(struct latstat*, int, int);
+void            getsched(struct schedparam*);
+int             setsched(struct schedparam*);
 void            wakeup(void*);
 void            yield(void);
 void		queuePush(struct queue*, struct proc*);
 int 		queueIsEmpty(struct queue*);
 void		dequeue(struct queue*);
-void		moveToHighQ(struct queue*, struct queue*, struct queue*);
-void		removeFromQueue(struct proc*, struct queue*, struct queue*, struct queue*);
+void		moveToHighQ(struct cpu*);
+void		queueRemove(struct queue*, struct proc*);
 
 
 // swtch.S
 void            swtch(struct context**, struct context*);
 
+// sleeplock.c
+void            acquiresleep(struct sleeplock*);
+void            acquiresleepshared(struct sleeplock*);
+void            releasesleep(struct sleeplock*);
+int             holdingsleep(struct sleeplock*);
+int             holdingsleepshared(struct sleeplock*);
+void            initsleeplock(struct sleeplock*, char*);
+
 // spinlock.c
 void            acquire(struct spinlock*);
 void            getcallerpcs(void*, uint*);
 int             holding(struct spinlock*);
+int             lockbench(int);
+void            lockbenchinit(void);
+int             getlockstat(struct lockstat*, int, int);
 void            initlock(struct spinlock*, char*);
 void            release(struct spinlock*);
 void            pushcli(void);
@@ -184,6 +221,7 @@ int             loaduvm(pde_t*, char*, struct inode*, uint, uint);
 pde_t*          copyuvm(pde_t*, uint);
 void            switchuvm(struct proc*);
 void            switchkvm(void);
+void            flushuvm(struct proc*);
 int             copyout(pde_t*, uint, void*, uint);
 void            clearpteu(pde_t *pgdir, char *uva);
 
@@ -14,7 +14,8 @@ struct inode {
   uint dev;           // Device number
   uint inum;          // Inode number
   int ref;            // Reference count
-  int flags;          // I_BUSY, I_VALID
+  struct sleeplock lock;
+  int flags;          // I_VALID
 
   short type;         // copy of disk inode
   short major;
@@ -23,7 +24,6 @@ struct inode {
   uint size;
   uint addrs[NDIRECT+1];
 };
-#define I_BUSY 0x1
 #define I_VALID 0x2
 
 // table mapping major device number to
@@ -36,6 +36,7 @@ struct devsw {
 extern struct devsw devsw[];
 
 #define CONSOLE 1
+#define SCHEDTRACE 2
 
 //PAGEBREAK!
 // Blank page.
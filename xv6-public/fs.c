@@ -17,6 +17,7 @@
 #include "proc.h"
 #include "spinlock.h"
 #include "fs.h"
+#include "sleeplock.h"
 #include "buf.h"
 #include "file.h"
 
@@ -132,9 +133,14 @@ bfree(int dev, uint b)
 //
 // * Locked: file system code may only examine and modify
 //   the information in an inode and its content if it
-//   has first locked the inode. The I_BUSY flag indicates
-//   that the inode is locked. ilock() sets I_BUSY,
-//   while iunlock clears it.
+//   has first locked the inode. ilock() acquires the
+//   inode's sleeplock, while iunlock releases it.
+//   Code that only reads the inode and its content, such
+//   as readi(), stati() and dirlookup(), may instead lock
+//   it shared with ilockshared(), so that many processes
+//   can read one file or directory at once. Code that
+//   modifies it, such as writei(), itrunc() and dirlink(),
+//   needs ilock().
 //
 // Thus a typical sequence is:
 //   ip = iget(dev, inum)
@@ -162,7 +168,11 @@ struct {
 void
 iinit(int dev)
 {
+  int i;
+
   initlock(&icache.lock, "icache");
+  for(i = 0; i < NINODE; i++)
+    initsleeplock(&icache.inode[i].lock, "inode");
   readsb(dev, &sb);
   cprintf("sb: size %d nblocks %d ninodes %d nlog %d logstart %d inodestart %d bmap start %d\n", sb.size,
           sb.nblocks, sb.ninodes, sb.nlog, sb.logstart, sb.inodestart, sb.bmapstart);
@@ -272,11 +282,7 @@ ilock(struct inode *ip)
   if(ip == 0 || ip->ref < 1)
     panic("ilock");
 
-  acquire(&icache.lock);
-  while(ip->flags & I_BUSY)
-    sleep(ip, &icache.lock);
-  ip->flags |= I_BUSY;
-  release(&icache.lock);
+  acquiresleep(&ip->lock);
 
   if(!(ip->flags & I_VALID)){
     bp = bread(ip->dev, IBLOCK(ip->inum, sb));
@@ -294,17 +300,33 @@ ilock(struct inode *ip)
   }
 }
 
-// Unlock the given inode.
+// Lock the given inode shared, for reading only.
+// Reads the inode from disk if necessary; that modifies it,
+// so it is done under ilock().
+void
+ilockshared(struct inode *ip)
+{
+  if(ip == 0 || ip->ref < 1)
+    panic("ilockshared");
+
+  acquiresleepshared(&ip->lock);
+  if(!(ip->flags & I_VALID)){
+    releasesleep(&ip->lock);
+    ilock(ip);
+    iunlock(ip);
+    // I_VALID stays set while we hold a reference.
+    acquiresleepshared(&ip->lock);
+  }
+}
+
+// Unlock the given inode, locked either way.
 void
 iunlock(struct inode *ip)
 {
-  if(ip == 0 || !(ip->flags & I_BUSY) || ip->ref < 1)
+  if(ip == 0 || !holdingsleepshared(&ip->lock) || ip->ref < 1)
     panic("iunlock");
 
-  acquire(&icache.lock);
-  ip->flags &= ~I_BUSY;
-  wakeup(ip);
-  release(&icache.lock);
+  releasesleep(&ip->lock);
 }
 
 // Drop a reference to an in-memory inode.
@@ -320,16 +342,15 @@ iput(struct inode *ip)
   acquire(&icache.lock);
   if(ip->ref == 1 && (ip->flags & I_VALID) && ip->nlink == 0){
     // inode has no links and no other references: truncate and free.
-    if(ip->flags & I_BUSY)
-      panic("iput busy");
-    ip->flags |= I_BUSY;
+    // No one else can hold the lock, so acquiresleep won't block.
     release(&icache.lock);
+    acquiresleep(&ip->lock);
     itrunc(ip);
     ip->type = 0;
     iupdate(ip);
+    releasesleep(&ip->lock);
     acquire(&icache.lock);
     ip->flags = 0;
-    wakeup(ip);
   }
   ip->ref--;
   release(&icache.lock);
@@ -395,6 +416,9 @@ itrunc(struct inode *ip)
   struct buf *bp;
   uint *a;
 
+  if(!holdingsleep(&ip->lock))
+    panic("itrunc");
+
   for(i = 0; i < NDIRECT; i++){
     if(ip->addrs[i]){
       bfree(ip->dev, ip->addrs[i]);
@@ -419,9 +443,12 @@ itrunc(struct inode *ip)
 }
 
 // Copy stat information from inode.
+// Caller must hold ip's lock, shared or exclusive.
 void
 stati(struct inode *ip, struct stat *st)
 {
+  if(!holdingsleepshared(&ip->lock))
+    panic("stati");
   st->dev = ip->dev;
   st->ino = ip->inum;
   st->type = ip->type;
@@ -431,6 +458,7 @@ stati(struct inode *ip, struct stat *st)
 
 //PAGEBREAK!
 // Read data from inode.
+// Caller must hold ip's lock, shared or exclusive.
 int
 readi(struct inode *ip, char *dst, uint off, uint n)
 {
@@ -459,12 +487,16 @@ readi(struct inode *ip, char *dst, uint off, uint n)
 
 // PAGEBREAK!
 // Write data to inode.
+// Caller must hold ip's lock exclusively.
 int
 writei(struct inode *ip, char *src, uint off, uint n)
 {
   uint tot, m;
   struct buf *bp;
 
+  if(!holdingsleep(&ip->lock))
+    panic("writei");
+
   if(ip->type == T_DEV){
     if(ip->major < 0 || ip->major >= NDEV || !devsw[ip->major].write)
       return -1;
@@ -502,12 +534,15 @@ namecmp(const char *s, const char *t)
 
 // Look for a directory entry in a directory.
 // If found, set *poff to byte offset of entry.
+// Caller must hold dp's lock, shared or exclusive.
 struct inode*
 dirlookup(struct inode *dp, char *name, uint *poff)
 {
   uint off, inum;
   struct dirent de;
 
+  if(!holdingsleepshared(&dp->lock))
+    panic("dirlookup");
   if(dp->type != T_DIR)
     panic("dirlookup not DIR");
 
@@ -529,6 +564,7 @@ dirlookup(struct inode *dp, char *name, uint *poff)
 }
 
 // Write a new directory entry (name, inum) into the directory dp.
+// Caller must hold dp's lock exclusively.
 int
 dirlink(struct inode *dp, char *name, uint inum)
 {
@@ -536,6 +572,8 @@ dirlink(struct inode *dp, char *name, uint inum)
   struct dirent de;
   struct inode *ip;
 
+  if(!holdingsleep(&dp->lock))
+    panic("dirlink");
   // Check that name is not present.
   if((ip = dirlookup(dp, name, 0)) != 0){
     iput(ip);
@@ -613,7 +651,7 @@ namex(char *path, int nameiparent, char *name)
     ip = idup(proc->cwd);
 
   while((path = skipelem(path, name)) != 0){
-    ilock(ip);
+    ilockshared(ip);
     if(ip->type != T_DIR){
       iunlockput(ip);
       return 0;
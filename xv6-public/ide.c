@@ -10,6 +10,7 @@
 #include "traps.h"
 #include "spinlock.h"
 #include "fs.h"
+#include "sleeplock.h"
 #include "buf.h"
 
 #define SECTOR_SIZE   512
@@ -135,8 +136,8 @@ iderw(struct buf *b)
 {
   struct buf **pp;
 
-  if(!(b->flags & B_BUSY))
-    panic("iderw: buf not busy");
+  if(!holdingsleep(&b->lock))
+    panic("iderw: buf not locked");
   if((b->flags & (B_VALID|B_DIRTY)) == B_VALID)
     panic("iderw: nothing to do");
   if(b->dev != 0 && !havedisk1)
@@ -10,7 +10,7 @@ char *argv[] = { "sh", 0 };
 int
 main(void)
 {
-  int pid, wpid;
+  int pid, wpid, fd;
 
   if(open("console", O_RDWR) < 0){
     mknod("console", 1, 1);
@@ -19,6 +19,11 @@ main(void)
   dup(0);  // stdout
   dup(0);  // stderr
 
+  if((fd = open("schedtrace", O_RDONLY)) < 0)
+    mknod("schedtrace", 2, 0);
+  else
+    close(fd);
+
   for(;;){
     printf(1, "init: starting sh\n");
     pid = fork();
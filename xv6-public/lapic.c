@@ -124,6 +124,19 @@ lapiceoi(void)
     lapicw(EOI, 0);
 }
 
+// Send an interrupt with the given vector to the cpu
+// with local APIC id apicid.
+void
+lapicipi(uchar apicid, int vector)
+{
+  if(!lapic)
+    return;
+  lapicw(ICRHI, apicid<<24);
+  lapicw(ICRLO, FIXED | ASSERT | vector);
+  while(lapic[ICRLO] & DELIVS)
+    ;
+}
+
 // Spin for a given number of microseconds.
 // On real hardware would want to tune this dynamically.
 void
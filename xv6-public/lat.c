@@ -0,0 +1,101 @@
+// Print wakeup-to-run latency percentiles from the scheduler's
+// per-cpu histograms: cycles from a process being queued to
+// its dispatch, for each MLFQ level and the real-time class.
+//   lat                    since boot (or the last reset)
+//   lat test2 20           reset, run test2 20, then print
+
+#include "param.h"
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "sched.h"
+
+struct latstat ls[NCPU];
+uint all[NLEVEL+1][LATBUCKETS], allmax[NLEVEL+1];
+
+// Print the upper bound of bucket b in cycles.
+void
+bound(int b)
+{
+  if(b+1 < 31)
+    printf(1, "\t%d", 1 << (b+1));
+  else
+    printf(1, "\t2^%d", b+1);
+}
+
+// Print count, p50, p99 and max for one histogram.
+void
+row(char *cpu, int level, uint *hist, uint max)
+{
+  uint n, sum;
+  int b, p50, p99;
+
+  n = 0;
+  for(b = 0; b < LATBUCKETS; b++)
+    n += hist[b];
+  if(n == 0)
+    return;
+  p50 = p99 = -1;
+  sum = 0;
+  for(b = 0; b < LATBUCKETS; b++){
+    sum += hist[b];
+    if(p50 < 0 && sum * 2 >= n)
+      p50 = b;
+    if(p99 < 0 && sum * 100 >= n * 99)
+      p99 = b;
+  }
+  printf(1, "%s\t", cpu);
+  if(level == NLEVEL)
+    printf(1, "rt");
+  else
+    printf(1, "%d", level);
+  printf(1, "\t%d", n);
+  bound(p50);
+  bound(p99);
+  if(max >= 0x80000000)
+    printf(1, "\t>2^31\n");
+  else
+    printf(1, "\t%d\n", max);
+}
+
+int
+main(int argc, char *argv[])
+{
+  char name[8];
+  int n, i, level, b, pid;
+
+  if(argc > 1){
+    getlatency(ls, 0, 1);
+    pid = fork();
+    if(pid < 0){
+      printf(2, "lat: fork failed\n");
+      exit();
+    }
+    if(pid == 0){
+      exec(argv[1], argv+1);
+      printf(2, "lat: exec %s failed\n", argv[1]);
+      exit();
+    }
+    wait();
+  }
+
+  n = getlatency(ls, NCPU, 0);
+  printf(1, "cpu\tlevel\tcount\tp50<\tp99<\tmax (cycles)\n");
+  for(i = 0; i < n; i++){
+    name[0] = 'c';
+    name[1] = 'p';
+    name[2] = 'u';
+    name[3] = '0' + ls[i].cpu;
+    name[4] = 0;
+    for(level = 0; level <= NLEVEL; level++){
+      row(name, level, ls[i].hist[level], ls[i].max[level]);
+      for(b = 0; b < LATBUCKETS; b++)
+        all[level][b] += ls[i].hist[level][b];
+      if(ls[i].max[level] > allmax[level])
+        allmax[level] = ls[i].max[level];
+    }
+  }
+  for(level = 0; level <= NLEVEL; level++)
+    row("all", level, all[level], allmax[level]);
+  exit();
+}
@@ -0,0 +1,75 @@
+// Spinlock contention microbenchmark.  Starts one process per
+// cpu (or nproc), each pinned to a cpu, that take and drop one
+// shared kernel spinlock for the given number of ticks.  Prints
+// how often each got it, the total rate, and min/max as a
+// measure of fairness.  Run it at several CPUS= settings.
+//   lockbench [nproc [ticks]]
+
+#include "param.h"
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "sched.h"
+
+struct cpustat cs[NCPU];
+
+int
+main(int argc, char *argv[])
+{
+  int ncpu, nproc, nticks, i, n, min, max, total;
+  int start[2], result[2];
+  char c;
+
+  ncpu = getcpustat(cs, NCPU);
+  nproc = ncpu;
+  nticks = 100;
+  if(argc > 1)
+    nproc = atoi(argv[1]);
+  if(argc > 2)
+    nticks = atoi(argv[2]);
+  if(nproc < 1 || nproc > NPROC/2 || nticks < 1){
+    printf(2, "usage: lockbench [nproc [ticks]]\n");
+    exit();
+  }
+  if(pipe(start) < 0 || pipe(result) < 0){
+    printf(2, "lockbench: pipe failed\n");
+    exit();
+  }
+
+  for(i = 0; i < nproc; i++){
+    n = fork();
+    if(n < 0){
+      printf(2, "lockbench: fork failed\n");
+      exit();
+    }
+    if(n == 0){
+      setaffinity(getpid(), 1 << (i % ncpu));
+      read(start[0], &c, 1);
+      n = lockbench(nticks);
+      write(result[1], &n, sizeof(n));
+      exit();
+    }
+  }
+  // Start them all at once.
+  for(i = 0; i < nproc; i++)
+    write(start[1], "x", 1);
+
+  min = max = total = 0;
+  for(i = 0; i < nproc; i++){
+    if(read(result[0], &n, sizeof(n)) != sizeof(n))
+      break;
+    printf(1, "proc %d: %d\n", i, n);
+    total += n;
+    if(i == 0 || n < min)
+      min = n;
+    if(n > max)
+      max = n;
+  }
+  for(i = 0; i < nproc; i++)
+    wait();
+
+  printf(1, "%d procs on %d cpus, %d ticks: %d acquires, %d per tick, "
+         "min/max %d%%\n", nproc, ncpu, nticks, total, total / nticks,
+         max ? min * 100 / max : 0);
+  exit();
+}
@@ -0,0 +1,79 @@
+// Print the kernel's spinlock contention statistics, busiest
+// (most cycles spent spinning) first.
+//   lockstat [-n N]             top N since boot or the last reset
+//   lockstat -r                 reset the counters
+//   lockstat [-n N] cmd args    reset, run cmd, print its top N
+// spin, hold and maxhold are in units of 1024 cycles; avgspin,
+// the mean wait of a contended acquire, is in cycles.
+
+#include "param.h"
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "lockstat.h"
+
+struct lockstat ls[NLOCKSTAT];
+
+// Mean cycles per contended acquire, without 64-bit division.
+uint
+avgspin(struct lockstat *s)
+{
+  if(s->contended == 0)
+    return 0;
+  if(s->spin >> 32)
+    return (uint)(s->spin >> 10) / s->contended << 10;
+  return (uint)s->spin / s->contended;
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct lockstat t;
+  int top, n, i, j, pid;
+
+  top = 10;
+  i = 1;
+  if(i < argc && strcmp(argv[i], "-r") == 0){
+    lockstat(ls, 0, 1);
+    exit();
+  }
+  if(i+1 < argc && strcmp(argv[i], "-n") == 0){
+    top = atoi(argv[i+1]);
+    i += 2;
+  }
+  if(i < argc){
+    lockstat(ls, 0, 1);
+    pid = fork();
+    if(pid < 0){
+      printf(2, "lockstat: fork failed\n");
+      exit();
+    }
+    if(pid == 0){
+      exec(argv[i], argv+i);
+      printf(2, "lockstat: exec %s failed\n", argv[i]);
+      exit();
+    }
+    wait();
+  }
+
+  n = lockstat(ls, NLOCKSTAT, 0);
+  // Sort by spin cycles, most first.
+  for(i = 1; i < n; i++){
+    t = ls[i];
+    for(j = i; j > 0 && ls[j-1].spin < t.spin; j--)
+      ls[j] = ls[j-1];
+    ls[j] = t;
+  }
+
+  printf(1, "name\t\tinits\tacquire\twaited\tspin\tavgspin\thold\tmaxhold\n");
+  for(i = 0; i < n && i < top; i++){
+    printf(1, "%s\t", ls[i].name);
+    if(strlen(ls[i].name) < 8)
+      printf(1, "\t");
+    printf(1, "%d\t%d\t%d\t%d\t%d\t%d\t%d\n",
+           ls[i].ninit, ls[i].acquires, ls[i].contended,
+           (uint)(ls[i].spin >> 10), avgspin(&ls[i]),
+           (uint)(ls[i].hold >> 10), (uint)(ls[i].maxhold >> 10));
+  }
+  exit();
+}
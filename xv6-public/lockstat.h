@@ -0,0 +1,16 @@
+// Spinlock contention statistics shared by the kernel and user
+// programs.  Uses uint64 from types.h.
+// The kernel keeps one entry per lock name, so all the pipes'
+// locks share the "pipe" entry; lockstat() copies them out.
+
+struct lockstat {
+  char name[16];
+  int ninit;            // initlock() calls with this name; a lock that
+                        // is initialized again, like a new pipe's,
+                        // counts each time
+  uint acquires;
+  uint contended;       // Acquires that had to wait
+  uint64 spin;          // Cycles spent waiting to acquire
+  uint64 hold;          // Cycles held
+  uint64 maxhold;       // Longest hold in cycles
+};
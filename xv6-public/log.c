@@ -3,6 +3,7 @@
 #include "param.h"
 #include "spinlock.h"
 #include "fs.h"
+#include "sleeplock.h"
 #include "buf.h"
 
 // Simple logging that allows concurrent FS system calls.
@@ -28,6 +28,7 @@ main(void)
   consoleinit();   // I/O devices & their interrupts
   uartinit();      // serial port
   pinit();         // process table
+  lockbenchinit(); // lockbench()'s lock
   tvinit();        // trap vectors
   binit();         // buffer cache
   fileinit();      // file table
@@ -45,7 +46,7 @@ main(void)
 static void
 mpenter(void)
 {
-  switchkvm(); 
+  lcr3(v2p(kpgdir));  // not switchkvm(): cpu isn't set up yet
   seginit();
   lapicinit();
   mpmain();
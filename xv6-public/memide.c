@@ -10,6 +10,7 @@
 #include "traps.h"
 #include "spinlock.h"
 #include "fs.h"
+#include "sleeplock.h"
 #include "buf.h"
 
 extern uchar _binary_fs_img_start[], _binary_fs_img_size[];
@@ -39,8 +40,8 @@ iderw(struct buf *b)
 {
   uchar *p;
 
-  if(!(b->flags & B_BUSY))
-    panic("iderw: buf not busy");
+  if(!holdingsleep(&b->lock))
+    panic("iderw: buf not locked");
   if((b->flags & (B_VALID|B_DIRTY)) == B_VALID)
     panic("iderw: nothing to do");
   if(b->dev != 1)
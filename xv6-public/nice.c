@@ -0,0 +1,29 @@
+// Run a command with a nice value.
+// nice n command [args...]
+// n runs from NICE_MIN (favored) to NICE_MAX (background).
+// The command's children inherit it.
+
+#include "param.h"
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "sched.h"
+
+int
+main(int argc, char *argv[])
+{
+  int n;
+
+  if(argc < 3){
+    printf(2, "usage: nice n command [args...]\n");
+    exit();
+  }
+  n = argv[1][0] == '-' ? -atoi(argv[1]+1) : atoi(argv[1]);
+  if(setpriority(getpid(), n) < 0){
+    printf(2, "nice: %s out of range %d to %d\n", argv[1], NICE_MIN, NICE_MAX);
+    exit();
+  }
+  exec(argv[2], argv+2);
+  printf(2, "nice: exec %s failed\n", argv[2]);
+  exit();
+}
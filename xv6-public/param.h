@@ -10,6 +10,17 @@
 #define MAXOPBLOCKS  10  // max # of blocks any FS op writes
 #define LOGSIZE      (MAXOPBLOCKS*3)  // max data blocks in on-disk log
 #define NBUF         (MAXOPBLOCKS*3)  // size of disk block cache
-#define FSSIZE       1000  // size of file system in blocks
-#define mtimes	     10    // the number of times a process runs to move down
-#define moveup	     50   // after how many runs the process should move up
+#define FSSIZE       2000  // size of file system in blocks
+#define mtimes	     10    // default number of used-up time slices to move down
+#define moveup	     50   // default timer ticks between boosts to the high queue
+#define NLEVELDEF     3   // default number of MLFQ priority levels in use
+#define NLEVEL        8   // maximum number of MLFQ priority levels, 0 is high
+#define NSLEEPQ      64   // buckets in the hash table of sleep channels
+#define NPIDHASH     64   // buckets in the hash table of pids
+#define DEFTICKETS  100   // default stride and lottery tickets per process
+#define RTDENSITY   900   // max real-time load admitted per cpu, per mille
+#define LATBUCKETS   48   // log2 buckets of wakeup-to-run latency in cycles
+#define NTRACE      512   // events in each cpu's scheduler trace ring
+#define NLOCKSTAT    32   // lock names with contention statistics
+#define NSHARED       4   // sleeplocks a process may hold shared at once
+                          // (default time slice per level is in proc.c)
@@ -0,0 +1,27 @@
+// Run a command restricted to a set of cpus.
+// pin mask command [args...]
+// Bit i of mask (decimal) allows cpu i.  The affinity is
+// inherited by the command's children.
+
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+int
+main(int argc, char *argv[])
+{
+  int mask;
+
+  if(argc < 3){
+    printf(2, "usage: pin mask command [args...]\n");
+    exit();
+  }
+  mask = atoi(argv[1]);
+  if(setaffinity(getpid(), mask) < 0){
+    printf(2, "pin: bad mask %s\n", argv[1]);
+    exit();
+  }
+  exec(argv[2], argv+2);
+  printf(2, "pin: exec %s failed\n", argv[2]);
+  exit();
+}
@@ -0,0 +1,85 @@
+// Bounce a byte between two processes over a pair of pipes.
+// Every round trip is two sleep/wakeup handoffs, so the time
+// per round trip is dominated by context switch cost.
+
+#include "param.h"
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "sched.h"
+
+#define ROUNDS  10000   // default number of round trips
+
+struct cpustat cs[NCPU];
+
+// Sum the cr3 loads and skips of all cpus.
+void
+cr3count(uint *loads, uint *skips)
+{
+  int i, n;
+
+  *loads = *skips = 0;
+  n = getcpustat(cs, NCPU);
+  for(i = 0; i < n; i++){
+    *loads += cs[i].cr3loads;
+    *skips += cs[i].cr3skips;
+  }
+}
+
+int
+main(int argc, char *argv[])
+{
+  int ping[2], pong[2], n, i, pid, start, elapsed;
+  uint loads, skips, loads1, skips1;
+  char c;
+
+  n = ROUNDS;
+  if(argc > 1)
+    n = atoi(argv[1]);
+  if(n <= 0){
+    printf(2, "usage: pingpong [rounds]\n");
+    exit();
+  }
+
+  if(pipe(ping) < 0 || pipe(pong) < 0){
+    printf(2, "pingpong: pipe failed\n");
+    exit();
+  }
+
+  pid = fork();
+  if(pid < 0){
+    printf(2, "pingpong: fork failed\n");
+    exit();
+  }
+  if(pid == 0){
+    close(ping[1]);
+    close(pong[0]);
+    while(read(ping[0], &c, 1) == 1)
+      write(pong[1], &c, 1);
+    exit();
+  }
+
+  close(ping[0]);
+  close(pong[1]);
+  c = 'x';
+  cr3count(&loads, &skips);
+  start = uptime();
+  for(i = 0; i < n; i++){
+    if(write(ping[1], &c, 1) != 1 || read(pong[0], &c, 1) != 1){
+      printf(2, "pingpong: round %d failed\n", i);
+      break;
+    }
+  }
+  elapsed = uptime() - start;
+  cr3count(&loads1, &skips1);
+  close(ping[1]);
+  wait();
+
+  printf(1, "pingpong: %d round trips in %d ticks", i, elapsed);
+  if(elapsed > 0)
+    printf(1, " (%d per tick)", i / elapsed);
+  printf(1, "\n");
+  printf(1, "pingpong: %d cr3 loads, %d skipped\n",
+    loads1 - loads, skips1 - skips);
+  exit();
+}
@@ -0,0 +1,104 @@
+// Priority inversion test.  A niced background writer keeps
+// rewriting a file, holding its inode lock, next to cpu hogs
+// that keep the writer off the cpu.  Meanwhile an interactive
+// reader reads the file once a tick.  Reports how long the
+// reads took and how many of its waits for the inode lock the
+// kernel counted as inversions.
+// pitest [hogs [reads]]
+
+#include "param.h"
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fcntl.h"
+#include "sched.h"
+
+#define DATAFILE "pitest.dat"
+#define NBLOCK 8
+
+volatile int sink;
+char buf[512];
+
+// Rewrite the file forever at the lowest priority.
+void
+writer(void)
+{
+  int fd, i;
+
+  setpriority(getpid(), NICE_MAX);
+  memset(buf, 'w', sizeof(buf));
+  for(;;){
+    if((fd = open(DATAFILE, O_RDWR)) < 0)
+      exit();
+    for(i = 0; i < NBLOCK; i++)
+      write(fd, buf, sizeof(buf));
+    close(fd);
+  }
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct procstat ps;
+  int hogs, reads, fd, i, n, t, worst, total, pids[NPROC];
+
+  hogs = 4;
+  reads = 200;
+  if(argc > 1)
+    hogs = atoi(argv[1]);
+  if(argc > 2)
+    reads = atoi(argv[2]);
+  if(hogs < 0 || hogs > NPROC/2 || reads < 1){
+    printf(2, "usage: pitest [hogs [reads]]\n");
+    exit();
+  }
+
+  if((fd = open(DATAFILE, O_CREATE|O_RDWR)) < 0){
+    printf(2, "pitest: cannot create %s\n", DATAFILE);
+    exit();
+  }
+  for(i = 0; i < NBLOCK; i++)
+    write(fd, buf, sizeof(buf));
+  close(fd);
+
+  n = 0;
+  if((pids[n] = fork()) == 0)
+    writer();
+  if(pids[n] > 0)
+    n++;
+  for(i = 0; i < hogs; i++){
+    if((pids[n] = fork()) < 0){
+      printf(2, "pitest: fork failed\n");
+      break;
+    }
+    if(pids[n] == 0)
+      for(;;)
+        sink++;
+    n++;
+  }
+
+  worst = total = 0;
+  for(i = 0; i < reads; i++){
+    sleep(1);
+    t = uptime();
+    if((fd = open(DATAFILE, O_RDONLY)) >= 0){
+      while(read(fd, buf, sizeof(buf)) > 0)
+        ;
+      close(fd);
+    }
+    t = uptime() - t;
+    total += t;
+    if(t > worst)
+      worst = t;
+  }
+  getprocstat(getpid(), &ps);
+  printf(1, "%d reads: %d ticks, worst %d; %d inversions, %d ticks\n",
+         reads, total, worst, ps.inversions, ps.invticks);
+
+  for(i = 0; i < n; i++)
+    kill(pids[i]);
+  for(i = 0; i < n; i++)
+    wait();
+  unlink(DATAFILE);
+  exit();
+}
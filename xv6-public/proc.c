@@ -6,66 +6,179 @@
 #include "x86.h"
 #include "proc.h"
 #include "spinlock.h"
+#include "sched.h"
+#include "traps.h"
+#include "fs.h"
+#include "sleeplock.h"
+#include "file.h"
 #include <stdio.h>
 
 
 struct {
   struct spinlock lock;
+  volatile uint seq;   // odd while the lock is held; see getprocs()
   struct proc proc[NPROC];
-
-  // create three queues of high medium and low priority
-  struct queue high;
-  struct queue med;
-  struct queue low;
-
+  struct proc *sleepq[NSLEEPQ];  // sleeping processes hashed by chan
+  struct proc *pidhash[NPIDHASH];  // in-use processes hashed by pid
+  struct proc *free;   // UNUSED slots, linked by freenext
+  int nthrottled;      // processes asleep on their rtnext; see rtwakeup()
 } ptable;
 
+#ifndef SCHEDPOLICY
+#define SCHEDPOLICY SCHED_MLFQ  // policy at boot; make SCHEDPOLICY=n
+#endif
+
 static struct proc *initproc;
-// amount of times the processes have run
-int runTimes = 0;
+// Scheduler parameters, changed at runtime by setsched()
+// under the ptable lock
+struct schedparam mlfq = {
+  NLEVELDEF,
+  { 1, 2, 8, 16, 32, 64, 128, 256 },
+  mtimes,
+  moveup,
+  SCHEDPOLICY,
+};
+
+// Why a process is being queued, for schedops.enqueue.
+#define ENQ_NEW    0   // just created
+#define ENQ_WAKE   1   // woken from sleep
+#define ENQ_YIELD  2   // gave up its cpu while still runnable
+
+// A scheduling policy.  The policies all keep runnable
+// processes on the per-cpu rq[] levels, so steal(),
+// setaffinity() and cpuQueueRemove() work under any of them;
+// they differ in which level a process goes on and which
+// process runs next.
+// Called with ptable.lock held, except tick, which trap()
+// calls on the running process.
+struct schedops {
+  char *name;
+  void (*enqueue)(struct cpu*, struct proc*, int);  // queue p on c
+  void (*dequeue)(struct proc*);          // take queued p off its queue
+  struct proc* (*pick_next)(struct cpu*); // dequeue c's next process
+  int (*slice)(struct proc*);             // ticks in p's next time slice
+  int (*tick)(struct proc*);              // a tick of running p; 1 to preempt
+  void (*boost)(struct cpu*);             // every mlfq.boost ticks, or 0
+};
+
+static struct schedops schedops[NSCHEDPOLICY];
+static struct schedops *policy = &schedops[SCHEDPOLICY];
+
+static void enqueue(struct cpu*, struct proc*, int);
+static void setnice(struct proc*, int);
+static void waited(struct proc*);
+static void trace(int, struct proc*);
+static void traceinit(void);
+static void rt_enqueue(struct proc*, int);
+static int rt_tick(struct proc*);
+static void rt_late(struct proc*);
 
 int nextpid = 1;
 extern void forkret(void);
 extern void trapret(void);
 
 static void wakeup1(void *chan);
+static void relinquish(int);
+static void cpuQueuePush(struct cpu*, struct proc*);
+static int runlevel(struct proc*);
+static struct proc* cpuDequeue(struct cpu*);
+static void cpuQueueRemove(struct proc*);
+static struct cpu* placecpu(struct proc*);
+static struct proc* steal(void);
+static int runnable(void);
+static void idle(void);
+static void resched(struct cpu*);
+static void wakeproc(struct proc*);
+static struct proc** sleepq(void*);
+static void sleepqinsert(struct proc*);
+static void sleepqremove(struct proc*);
+static void getstat(struct proc*, struct procstat*);
+static struct proc* pickproc(void);
+static void dispatch(struct proc*);
+static void putback(struct proc*);
+static int waitchild(struct procstat*);
+static void childpush(struct proc**, struct proc*);
+static void childremove(struct proc*);
+static void freeproc(struct proc*);
+static struct proc* findproc(int);
 
 void
 pinit(void)
 {
+  struct proc *p;
+
   initlock(&ptable.lock, "ptable");
+  for(p = &ptable.proc[NPROC-1]; p >= ptable.proc; p--){
+    p->freenext = ptable.free;
+    ptable.free = p;
+  }
+  traceinit();
+}
+
+// Acquire and release ptable.lock, bumping ptable.seq on the way
+// in and out so lock-free readers can tell the table may have
+// changed under them.
+static void
+ptacquire(void)
+{
+  acquire(&ptable.lock);
+  ptable.seq++;
+}
+
+static void
+ptrelease(void)
+{
+  ptable.seq++;
+  release(&ptable.lock);
 }
 
 //PAGEBREAK: 32
-// Look in the process table for an UNUSED proc.
+// Take an UNUSED proc off the free list.
 // If found, change state to EMBRYO and initialize
 // state required to run in the kernel.
+// A fork child inherits the caller's affinity and nice value
+// here, before its pid can be found, so a setaffinity() or
+// setpriority() on the EMBRYO child isn't overwritten.
 // Otherwise return 0.
 static struct proc*
 allocproc(void)
 {
   struct proc *p;
+  struct proc **pp;
   char *sp;
 
-  acquire(&ptable.lock);
-  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++)
-    if(p->state == UNUSED)
-      goto found;
-  release(&ptable.lock);
-  return 0;
+  ptacquire();
+  if((p = ptable.free) == 0){
+    ptrelease();
+    return 0;
+  }
+  ptable.free = p->freenext;
+  p->freenext = 0;
 
-found:
   p->state = EMBRYO;
   p->priority=0;
   p->procmtimes =0;
+  p->quantum = 0;
+  p->lastcpu = -1;
+  p->affinity = proc ? proc->affinity : ~0;
+  setnice(p, proc ? proc->nice : 0);
+  p->pass = 0;
+  p->rtperiod = 0;
+  p->inherited = NLEVEL;
+  p->nsleeplocks = 0;
+  memset(p->shared, 0, sizeof(p->shared));
   p->pid = nextpid++;
-  release(&ptable.lock);
+  pp = &ptable.pidhash[(uint)p->pid % NPIDHASH];
+  p->pidnext = *pp;
+  *pp = p;
+  ptrelease();
 
 
   // Allocate kernel stack.
   if((p->kstack = kalloc()) == 0){
-    p->state = UNUSED;
-   
+    ptacquire();
+    freeproc(p);
+    ptrelease();
     return 0;
   }
   sp = p->kstack + KSTACKSIZE;
@@ -91,6 +204,21 @@ found:
   p->running =0;
   release(&tickslock);
 
+  // clear the statistics left by the slot's last process
+  p->stamp = p->created;
+  p->response = 0;
+  p->cputicks = 0;
+  p->waitticks = 0;
+  p->sleepticks = 0;
+  p->voluntary = 0;
+  p->involuntary = 0;
+  memset(p->levelticks, 0, sizeof(p->levelticks));
+  p->migrations = 0;
+  p->rtmissed = 0;
+  p->rtthrottled = 0;
+  p->inversions = 0;
+  p->invticks = 0;
+
 
   return p;
 }
@@ -118,24 +246,14 @@ userinit(void)
   p->tf->esp = PGSIZE;
   p->tf->eip = 0;  // beginning of initcode.S
 
-
-  // initialize the three queues
-  ptable.high.head = NULL;
-  ptable.high.tail = NULL;
-  ptable.med.head = NULL;
-  ptable.med.tail = NULL;
-  ptable.low.head = NULL;
-  ptable.low.tail = NULL;
-
   safestrcpy(p->name, "initcode", sizeof(p->name));
   p->cwd = namei("/");
 
   p->state = RUNNABLE;
-  // set priority to 0(high priority) for the new process
-  p->priority = 0;
-  p->procmtimes =0;
-  // put the process in the highest priority queue
-  queuePush(&ptable.high, p);
+  p->stamp = ticks;
+  ptacquire();
+  enqueue(cpu, p, ENQ_NEW);
+  ptrelease();
 }
 
 // Grow current process's memory by n bytes.
@@ -154,7 +272,7 @@ growproc(int n)
       return -1;
   }
   proc->sz = sz;
-  switchuvm(proc);
+  flushuvm(proc);
   return 0;
 }
 
@@ -175,7 +293,9 @@ fork(void)
   if((np->pgdir = copyuvm(proc->pgdir, proc->sz)) == 0){
     kfree(np->kstack);
     np->kstack = 0;
-    np->state = UNUSED;
+    ptacquire();
+    freeproc(np);
+    ptrelease();
     return -1;
   }
   np->sz = proc->sz;
@@ -197,12 +317,14 @@ fork(void)
   pid = np->pid;
 
   // lock to force the compiler to emit the np->state write last.
-  acquire(&ptable.lock);
+  ptacquire();
+  childpush(&proc->children, np);
   np->state = RUNNABLE;
-  np->priority=0;
+  np->stamp = ticks;
   
-  queuePush(&ptable.high, np);
-  release(&ptable.lock);
+  enqueue(placecpu(np), np, ENQ_NEW);
+  resched(np->rqcpu);
+  ptrelease();
   
 	
   return pid;
@@ -240,106 +362,108 @@ exit(void)
   proc->ended = ticks;
   release(&tickslock);
 
-  acquire(&ptable.lock);
+  ptacquire();
 
   // Parent might be sleeping in wait().
   wakeup1(proc->parent);
 
   // Pass abandoned children to init.
-  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
-    if(p->parent == proc){
-      p->parent = initproc;
-      if(p->state == ZOMBIE)
-        wakeup1(initproc);
-    }
+  while((p = proc->children) != 0){
+    childremove(p);
+    p->parent = initproc;
+    childpush(&initproc->children, p);
+  }
+  if(proc->zombies)
+    wakeup1(initproc);
+  while((p = proc->zombies) != 0){
+    childremove(p);
+    p->parent = initproc;
+    childpush(&initproc->zombies, p);
   }
 
+  // Move to the parent's list of children to reap.
+  childremove(proc);
+  childpush(&proc->parent->zombies, proc);
+
+  // Give back any real-time capacity.
+  if(proc->rtperiod)
+    cpus[proc->rtcpu].rtdensity -= proc->rtdensity;
+
   // Jump into the scheduler, never to return.
   proc->state = ZOMBIE;
+  trace(SE_EXIT, proc);
+  policy->dequeue(proc);
   sched();
   panic("zombie exit");
 }
 
+// Wait for a child process to exit, report its turnaround time
+// and number of dispatches, and return its pid.
+// Return -1 if this process has no children.
 int
 waitstat(int* turnaround, int* runtime)
 {
-	  struct proc *p;
-	  int havekids, pid;
-
-	  acquire(&ptable.lock);
-	  for(;;){
-		// Scan through table looking for zombie children.
-		havekids = 0;
-		for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
-			if(p->parent != proc)
-				continue;
-			havekids = 1;
-			if(p->state == ZOMBIE){
-				pid = p->pid;            
-				kfree(p->kstack);
-				p->kstack = 0 ;      
-				freevm(p->pgdir);			
-				p->state = UNUSED;		   
-				p->pid = 0;			    
-				p->parent = 0;		    
-				p->name[0] = 0;		    
-				p->killed = 0;		    
-				*turnaround = p->ended - p->created;		    
-				*runtime = p->running;
-				release(&ptable.lock);			    
-				return pid;
-			    
-			}
-			    
-		}
-		// No point waiting if we don't have any children.
-		if(!havekids || proc->killed){
-			release(&ptable.lock);
-			return -1;
-		}
+	struct procstat ps;
+	int pid;
 
-		// Wait for children to exit.  (See wakeup1 call in proc_exit.)
-		sleep(proc, &ptable.lock);  //DOC: wait-sleep
-	  }
+	pid = waitstat2(&ps);
+	if(pid >= 0){
+		*turnaround = ps.ended - ps.created;
+		*runtime = ps.dispatches;
+	}
+	return pid;
 }
 
-
+// Wait for a child process to exit, fill *ps with its
+// scheduling statistics, and return its pid.
+// Return -1 if this process has no children.
+int
+waitstat2(struct procstat *ps)
+{
+	return waitchild(ps);
+}
 
 // Wait for a child process to exit and return its pid.
 // Return -1 if this process has no children.
 int
 wait(void)
+{
+  return waitchild(0);
+}
+
+// Wait for a child process to exit and return its pid.
+// If ps is non-zero, fill it with the child's statistics.
+// Exited children are on proc->zombies, so this takes
+// time independent of the size of the process table.
+// Return -1 if this process has no children.
+static int
+waitchild(struct procstat *ps)
 {
   struct proc *p;
-  int havekids, pid;
+  int pid;
 
-  acquire(&ptable.lock);
+  ptacquire();
   for(;;){
-    // Scan through table looking for zombie children.
-    havekids = 0;
-    for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
-      if(p->parent != proc)
-        continue;
-      havekids = 1;
-      if(p->state == ZOMBIE){
-        // Found one.
-        pid = p->pid;
-        kfree(p->kstack);
-        p->kstack = 0;
-        freevm(p->pgdir);
-        p->state = UNUSED;
-        p->pid = 0;
-        p->parent = 0;
-        p->name[0] = 0;
-        p->killed = 0;
-        release(&ptable.lock);
-        return pid;
-      }
+    if((p = proc->zombies) != 0){
+      // Found one.
+      childremove(p);
+      pid = p->pid;
+      if(ps)
+        getstat(p, ps);
+      kfree(p->kstack);
+      p->kstack = 0;
+      freevm(p->pgdir);
+      freeproc(p);
+      p->parent = 0;
+      p->name[0] = 0;
+      p->killed = 0;
+      ptrelease();
+      return pid;
     }
 
     // No point waiting if we don't have any children.
-    if(!havekids || proc->killed){
-      release(&ptable.lock);
+    if(proc->children == 0 || proc->killed){
+      ptrelease();
       return -1;
     }
 
@@ -348,6 +472,66 @@ wait(void)
   }
 }
 
+// Return the in-use process with the given pid, or 0.
+// The ptable lock must be held.
+static struct proc*
+findproc(int pid)
+{
+  struct proc *p;
+
+  if(pid <= 0)
+    return 0;
+  for(p = ptable.pidhash[(uint)pid % NPIDHASH]; p; p = p->pidnext)
+    if(p->pid == pid)
+      return p;
+  return 0;
+}
+
+// Mark p UNUSED, drop it from the pid hash and put
+// it back on the free list.
+// The ptable lock must be held.
+static void
+freeproc(struct proc *p)
+{
+  struct proc **pp;
+
+  for(pp = &ptable.pidhash[(uint)p->pid % NPIDHASH]; *pp; pp = &(*pp)->pidnext){
+    if(*pp == p){
+      *pp = p->pidnext;
+      break;
+    }
+  }
+  p->pidnext = 0;
+  p->state = UNUSED;
+  p->pid = 0;
+  p->freenext = ptable.free;
+  ptable.free = p;
+}
+
+// Push p onto the child list at *head.
+// The ptable lock must be held.
+static void
+childpush(struct proc **head, struct proc *p)
+{
+  p->sibling = *head;
+  if(p->sibling)
+    p->sibling->psibling = &p->sibling;
+  p->psibling = head;
+  *head = p;
+}
+
+// Take p off its parent's children or zombies list.
+// The ptable lock must be held.
+static void
+childremove(struct proc *p)
+{
+  *p->psibling = p->sibling;
+  if(p->sibling)
+    p->sibling->psibling = p->psibling;
+  p->sibling = 0;
+  p->psibling = 0;
+}
+
 //PAGEBREAK: 42
 // Per-CPU process scheduler.
 // Each CPU calls scheduler() after setting itself up.
@@ -365,93 +549,306 @@ scheduler(void)
     // Enable interrupts on this processor.
     sti();
 
-    // Loop over process table looking for process to run.
-    acquire(&ptable.lock);
-    for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
-   
-            
-      runTimes= runTimes+1;
-      if (runTimes == moveup){	
-      	moveToHighQ(&ptable.high, &ptable.med, &ptable.low);
-	runTimes=0;
-      }
+    // Nothing queued on any cpu: halt instead of spinning, so
+    // idle cpus don't bounce the ptable.lock cache line that
+    // busy cpus need for yield() and sleep().
+    if(runnable() == 0){
+      idle();
+      continue;
+    }
 
-      if(p->state != RUNNABLE)
-        continue;
-	
-	
-		
-	if(queueIsEmpty(&ptable.high) == 0){
-		//cprintf("pid: %d high queue\n", p->pid);
-		p = ptable.high.head;
-		p->running++;
-		proc =p;
-		switchuvm(p);
-		p->state= RUNNING;
-		swtch(&cpu->scheduler, proc->context);
-		switchkvm();
-		p->priority=1;
-		dequeue(&ptable.high);
-		queuePush(&ptable.med, p);
-	}
-	else if(queueIsEmpty(&ptable.high) == 1 && queueIsEmpty(&ptable.med) == 0){
-		//cprintf("pid: %d med queue\n", p->pid);
-		p = ptable.med.head;
-		p->running++;
-		proc =p;
-		switchuvm(p);
-		p->state= RUNNING;
-		swtch(&cpu->scheduler, proc->context);
-		switchkvm();
-		p->procmtimes++;
-
-		if(p->procmtimes == mtimes){
-			p->priority=2;
-			dequeue(&ptable.med);
-			queuePush(&ptable.low, p);
-		}
-	}
-	//else if(queueIsEmpty(&ptable.high) == 1 && queueIsEmpty(&ptable.med) == 1 && queueIsEmpty(&ptable.low) == 0) {
-	else{
-		//cprintf("pid: %d low queue\n", p->pid);
-		p = ptable.low.head;
-		p->running++;
-		proc =p;
-		switchuvm(p);
-		p->state= RUNNING;
-		swtch(&cpu->scheduler, proc->context);
-		switchkvm();
-		p->procmtimes++;
-		
-	}
-      
-
-      // Switch to chosen process.  It is the process's job
-      // to release ptable.lock and then reacquire it
-      // before jumping back to us.
-/*      p->running++;
-      proc = p;
-      switchuvm(p);
-      p->state = RUNNING;
-      swtch(&cpu->scheduler, proc->context);
-      switchkvm();
-*/
-      // Process is done running for now.
-      // It should have changed its p->state before coming back.
-      proc = 0;
+    // Interrupts stay off until the hlt below if there turns
+    // out to be nothing this cpu can run.
+    cli();
+    ptacquire();
+    if((p = pickproc()) == 0){
+      // Only work this cpu can't take is queued: processes
+      // whose affinity excludes it, or jobs on a sibling's rtq.
+      // Halt rather than spin on ptable.lock until it drains.
+      // idle is set under ptable.lock, so whoever queues work
+      // after pickproc() looked sends an IPI, which is held
+      // pending until stihlt() and ends the hlt.
+      xchg(&cpu->idle, 1);
+      ptrelease();
+      stihlt();
+      cpu->idle = 0;
+      continue;
+    }
+
+    // Switch to chosen process.  It is the process's job
+    // to release ptable.lock and then reacquire it
+    // before jumping back to us.
+    dispatch(p);
+    swtch(&cpu->scheduler, p->context);
+    switchkvm();
+
+    // Process is done running for now.
+    // sched() has already put it back on a queue if it is still
+    // runnable, and it may have switched straight to other
+    // processes since, so the one that came back need not be p.
+    proc = 0;
+    ptrelease();
+  }
+}
 
+// Choose the next process for this cpu: the real-time process
+// with the earliest deadline, else the policy's pick from its own
+// queues, else one stolen from the busiest sibling.
+// Return 0 if there is nothing to run.
+// The ptable lock must be held.
+static struct proc*
+pickproc(void)
+{
+  struct proc *p;
+
+  // Boost every mlfq.boost timer ticks, measured per cpu, so the
+  // period doesn't depend on how often the scheduler runs.
+  // A racy read of ticks is fine; it only moves the boost a tick.
+  if(ticks - cpu->lastboost >= mlfq.boost){
+    if(policy->boost){
+      policy->boost(cpu);
+      trace(SE_BOOST, 0);
     }
-    release(&ptable.lock);
+    cpu->lastboost = ticks;
+  }
+
+  if((p = cpu->rtq.head) != 0){
+    cpuQueueRemove(p);
+    rt_late(p);
+    return p;
+  }
+  if((p = policy->pick_next(cpu)) == 0)
+    p = steal();
+  return p;
+}
+
+// Make p the process running on this cpu and start a new
+// time slice if it used up the last one.
+// The ptable lock must be held.
+static void
+dispatch(struct proc *p)
+{
+  if(p->state != RUNNABLE)
+    panic("dispatch: queued process not runnable");
+  trace(SE_DISPATCH, p);
+  if(p->running == 0)
+    p->response = ticks - p->created;
+  p->waitticks += ticks - p->stamp;
+  waited(p);
+  p->running++;
+  if(p->lastcpu >= 0 && p->lastcpu != cpu->id)
+    p->migrations++;
+  p->lastcpu = cpu->id;
+  if(p->quantum <= 0)
+    p->quantum = policy->slice(p);
+  proc = p;
+  switchuvm(p);
+  p->state = RUNNING;
+}
 
+// Finish p's run on this cpu: put it back on our queues if it
+// is still runnable (or on an allowed cpu's, if setaffinity()
+// moved it off ours).  Sleepers are queued again by wakeup.
+// The ptable lock must be held.
+static void
+putback(struct proc *p)
+{
+  if(p->state == RUNNABLE){
+    enqueue(placecpu(p), p, ENQ_YIELD);
+    if(p->rqcpu != cpu)
+      resched(p->rqcpu);
   }
 }
 
+// Scheduler trace: a ring of events per cpu.  Only the owning
+// cpu writes its ring, always with the ptable lock held, which
+// keeps its writers apart and interrupts off.  The reader takes
+// tracelock rather than the ptable lock: it only moves tail,
+// after the barriers below, and swaps dropped to zero with
+// xchg while writers add to it with a locked add, so the two
+// sides share no lock.  A full ring drops new events and
+// counts them.  tracelock only keeps readers apart.
+static struct {
+  volatile uint head;   // next slot the cpu writes
+  volatile uint tail;   // next slot the reader reads
+  volatile uint dropped; // events lost since the last read
+  struct schedevent ev[NTRACE];
+} tracering[NCPU];
+static struct spinlock tracelock;
+static int tracing;
+
+// Record an event about p (or none) on this cpu's ring.
+static void
+trace(int type, struct proc *p)
+{
+  struct schedevent *e;
+  uint h;
+  int i;
+
+  if(!tracing)
+    return;
+  i = cpu - cpus;
+  h = tracering[i].head;
+  if(h - tracering[i].tail >= NTRACE){
+    fetchadd(&tracering[i].dropped, 1);
+    return;
+  }
+  e = &tracering[i].ev[h % NTRACE];
+  e->tsc = rdtsc();
+  e->type = type;
+  e->cpu = cpu->id;
+  e->pid = p ? p->pid : 0;
+  e->level = p ? (p->rtperiod ? NLEVEL : p->priority) : 0;
+  // Fill in the event before publishing it.
+  __sync_synchronize();
+  tracering[i].head = h + 1;
+}
+
+// Read whole events from every cpu's ring, oldest first on each
+// cpu; events from different cpus are not merged by time.
+// Returns 0 when there is nothing to read rather than waiting.
+static int
+schedtraceread(struct inode *ip, char *dst, int n)
+{
+  struct schedevent *e;
+  uint t, d;
+  int i, m;
+
+  acquire(&tracelock);
+  m = 0;
+  for(i = 0; i < ncpu; i++){
+    if(tracering[i].dropped && m + sizeof(*e) <= n){
+      d = xchg(&tracering[i].dropped, 0);
+      e = (struct schedevent*)(dst + m);
+      memset(e, 0, sizeof(*e));
+      e->type = SE_DROPPED;
+      e->cpu = cpus[i].id;
+      e->pid = d;
+      m += sizeof(*e);
+    }
+    t = tracering[i].tail;
+    while(t != tracering[i].head && m + sizeof(*e) <= n){
+      // Read the event only after seeing head move past it.
+      __sync_synchronize();
+      memmove(dst + m, &tracering[i].ev[t % NTRACE], sizeof(*e));
+      m += sizeof(*e);
+      t++;
+    }
+    // Done with the slots before handing them back.
+    __sync_synchronize();
+    tracering[i].tail = t;
+  }
+  release(&tracelock);
+  return m;
+}
+
+// Writing '1' turns tracing on, '0' turns it off.
+static int
+schedtracewrite(struct inode *ip, char *src, int n)
+{
+  if(n > 0)
+    tracing = src[0] == '1';
+  return n;
+}
+
+static void
+traceinit(void)
+{
+  initlock(&tracelock, "schedtrace");
+  devsw[SCHEDTRACE].read = schedtraceread;
+  devsw[SCHEDTRACE].write = schedtracewrite;
+}
+
+// Add the cycles p waited since enqueue() to this cpu's
+// latency histogram for p's level.
+// The ptable lock must be held.
+static void
+waited(struct proc *p)
+{
+  uint64 d;
+  int row, b;
+
+  d = rdtsc() - p->enqtsc;
+  row = p->rtperiod ? NLEVEL : p->priority;
+  if(d >> 32)
+    b = 32 + bsr(d >> 32);
+  else
+    b = (uint)d ? bsr(d) : 0;
+  if(b >= LATBUCKETS)
+    b = LATBUCKETS-1;
+  cpu->lathist[row][b]++;
+  if(d >> 32)
+    cpu->latmax[row] = ~0;
+  else if((uint)d > cpu->latmax[row])
+    cpu->latmax[row] = d;
+}
+
+// Copy the latency histograms of up to n cpus to ls and return
+// how many were copied.  If reset is set, clear them too.
+int
+getlatency(struct latstat *ls, int n, int reset)
+{
+  struct cpu *c;
+  int i;
+
+  ptacquire();
+  for(i = 0; i < n && i < ncpu; i++){
+    c = &cpus[i];
+    ls[i].cpu = c->id;
+    memmove(ls[i].hist, c->lathist, sizeof(ls[i].hist));
+    memmove(ls[i].max, c->latmax, sizeof(ls[i].max));
+  }
+  if(reset){
+    for(c = cpus; c < cpus+ncpu; c++){
+      memset(c->lathist, 0, sizeof(c->lathist));
+      memset(c->latmax, 0, sizeof(c->latmax));
+    }
+  }
+  ptrelease();
+  return i;
+}
+
+// Queue runnable p on c, or on its own cpu's real-time queue.
+// The ptable lock must be held.
+static void
+enqueue(struct cpu *c, struct proc *p, int why)
+{
+  // Stamped here rather than in queuePush(), so boosts and
+  // affinity moves don't restart the wait.
+  p->enqtsc = rdtsc();
+  if(p->rtperiod)
+    rt_enqueue(p, why);
+  else
+    policy->enqueue(c, p, why);
+  trace(SE_ENQUEUE, p);
+}
+
+// Account for a timer tick of the running process p.
+// Return 1 if p should give up its cpu: its time slice is up,
+// or a real-time process with an earlier deadline is waiting.
+// A real-time process that used up its budget sleeps here
+// until its next period.
+int
+schedtick(struct proc *p)
+{
+  if(p->rtperiod)
+    return rt_tick(p);
+  // A racy look at rtq: at worst we preempt a tick late.
+  if(cpu->rtq.head)
+    return 1;
+  return policy->tick(p);
+}
+
 // Enter scheduler.  Must hold only ptable.lock
 // and have changed proc->state.
+// If this cpu has another process to run, switch straight
+// to it instead: that saves a swtch through the scheduler's
+// stack and the scheduler's switch to kpgdir.
 void
 sched(void)
 {
   int intena;
+  struct proc *p, *np;
 
   if(!holding(&ptable.lock))
     panic("sched ptable.lock");
@@ -462,21 +859,43 @@ sched(void)
   if(readeflags()&FL_IF)
     panic("sched interruptible");
   intena = cpu->intena;
-  swtch(&proc->context, cpu->scheduler);
+  p = proc;
+  putback(p);
+  if((np = pickproc()) == 0){
+    // Nothing to run: let scheduler() idle or wait.
+    swtch(&p->context, cpu->scheduler);
+  } else {
+    dispatch(np);
+    if(np != p)
+      swtch(&p->context, np->context);
+  }
   cpu->intena = intena;
 }
 
 // Give up the CPU for one scheduling round.
-void
-yield(void)
+// Only a preemption (by the timer or the scheduler) counts as
+// an involuntary switch; a process that moves itself after
+// changing its own affinity or class doesn't.
+static void
+relinquish(int preempted)
 {
-  acquire(&ptable.lock);  //DOC: yieldlock
+  ptacquire();  //DOC: yieldlock
   proc->state = RUNNABLE;
-  proc->priority=0;
-  //cprintf("yield\n");
-  queuePush(&ptable.high, proc);
+  proc->stamp = ticks;
+  if(preempted)
+    proc->involuntary++;
+  trace(SE_PREEMPT, proc);
+  // sched() puts us back on this cpu's queues.
   sched();
-  release(&ptable.lock);
+  ptrelease();
+}
+
+// Preempt the running process: its time slice is up or
+// something should run before it.
+void
+yield(void)
+{
+  relinquish(1);
 }
 
 // A fork child's very first scheduling by scheduler()
@@ -486,7 +905,7 @@ forkret(void)
 {
   static int first = 1;
   // Still holding ptable.lock from scheduler.
-  release(&ptable.lock);
+  ptrelease();
 
   if (first) {
     // Some initialization functions must be run in the context
@@ -518,14 +937,25 @@ sleep(void *chan, struct spinlock *lk)
   // (wakeup runs with ptable.lock locked),
   // so it's okay to release lk.
   if(lk != &ptable.lock){  //DOC: sleeplock0
-    acquire(&ptable.lock);  //DOC: sleeplock1
+    ptacquire();  //DOC: sleeplock1
     release(lk);
   }
 
+  // A real-time job is finished when its process sleeps,
+  // other than when it is throttled in rt_tick().
+  if(proc->rtperiod && chan != &proc->rtnext){
+    rt_late(proc);
+    proc->rtdone = 1;
+  }
+
   // Go to sleep.
   proc->chan = chan;
   proc->state = SLEEPING;
- // removeFromQueue(proc, &ptable.high, &ptable.med, &ptable.low);
+  sleepqinsert(proc);
+  trace(SE_SLEEP, proc);
+  proc->stamp = ticks;
+  proc->voluntary++;
+  policy->dequeue(proc);
   sched();
 
   // Tidy up.
@@ -533,34 +963,103 @@ sleep(void *chan, struct spinlock *lk)
 
   // Reacquire original lock.
   if(lk != &ptable.lock){  //DOC: sleeplock2
-    release(&ptable.lock);
+    ptrelease();
     acquire(lk);
   }
 }
 
+// The sleepq bucket that holds processes sleeping on chan.
+// Multiplying by a large odd constant spreads nearby addresses,
+// such as neighbouring proc or buf structs, over the buckets.
+static struct proc**
+sleepq(void *chan)
+{
+  return &ptable.sleepq[(((uint)chan * 2654435761U) >> 16) % NSLEEPQ];
+}
+
+// Add p to the bucket for p->chan.
+// The ptable lock must be held.
+static void
+sleepqinsert(struct proc *p)
+{
+  struct proc **pp;
+
+  if(p->chan == &p->rtnext)
+    ptable.nthrottled++;
+  pp = sleepq(p->chan);
+  p->chnext = *pp;
+  if(p->chnext)
+    p->chnext->chprev = &p->chnext;
+  p->chprev = pp;
+  *pp = p;
+}
+
+// Take p out of its sleepq bucket.
+// The ptable lock must be held.
+static void
+sleepqremove(struct proc *p)
+{
+  if(p->chan == &p->rtnext)
+    ptable.nthrottled--;
+  *p->chprev = p->chnext;
+  if(p->chnext)
+    p->chnext->chprev = p->chprev;
+  p->chnext = 0;
+  p->chprev = 0;
+}
+
+// Make sleeping p runnable with a fresh time slice and queue
+// it on the cpu it last ran on, whose cache may still hold its
+// working set.
+// The ptable lock must be held.
+static void
+wakeproc(struct proc *p)
+{
+  // A real-time process woken before its next release, most
+  // often by the tick wakeups of sys_sleep(), waits on
+  // p->rtnext like a throttled one until rtwakeup() releases
+  // its next job.  Queued now, it would carry the finished
+  // job's past deadline to the head of rtq.
+  if(p->rtperiod && !p->killed && p->chan != &p->rtnext &&
+     (int)(ticks - p->rtnext) < 0){
+    sleepqremove(p);
+    p->chan = &p->rtnext;
+    sleepqinsert(p);
+    return;
+  }
+  sleepqremove(p);
+  p->sleepticks += ticks - p->stamp;
+  p->stamp = ticks;
+  p->state = RUNNABLE;
+  p->quantum = 0;
+  trace(SE_WAKEUP, p);
+  enqueue(placecpu(p), p, ENQ_WAKE);
+  resched(p->rqcpu);
+}
+
 //PAGEBREAK!
 // Wake up all processes sleeping on chan.
+// Only looks at chan's sleepq bucket, not the whole table.
 // The ptable lock must be held.
 static void
 wakeup1(void *chan)
 {
-  struct proc *p;
+  struct proc *p, *next;
 
-  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++)
-    if(p->state == SLEEPING && p->chan == chan){
-      p->state = RUNNABLE;
-      p->priority = 0;
-      queuePush(&ptable.high, p);
-    }
+  for(p = *sleepq(chan); p; p = next){
+    next = p->chnext;
+    if(p->chan == chan)
+      wakeproc(p);
+  }
 }
 
 // Wake up all processes sleeping on chan.
 void
 wakeup(void *chan)
 {
-  acquire(&ptable.lock);
+  ptacquire();
   wakeup1(chan);
-  release(&ptable.lock);
+  ptrelease();
 }
 
 // Kill the process with the given pid.
@@ -571,26 +1070,351 @@ kill(int pid)
 {
   struct proc *p;
 
-  acquire(&ptable.lock);
-  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
-    if(p->pid == pid){
-      p->killed = 1;
-      // remove the process from the queue
-      // removeFromQueue(p, &ptable.high, &ptable.med, &ptable.low);
-	
-      // Wake process from sleep if necessary.
-      if(p->state == SLEEPING){
-        p->state = RUNNABLE;
-	p->priority = 0;
-	queuePush(&ptable.high, p);
+  ptacquire();
+  if((p = findproc(pid)) != 0){
+    p->killed = 1;
+    // A queued process stays on its run queue: it has
+    // to run to notice p->killed and exit.
+
+    // Wake process from sleep if necessary.
+    if(p->state == SLEEPING)
+      wakeproc(p);
+    ptrelease();
+    return 0;
+  }
+  ptrelease();
+
+  return -1;
+}
+
+// Fill *ps with the scheduling statistics of the process
+// with the given pid.
+// Return -1 if there is no such process.
+int
+getprocstat(int pid, struct procstat *ps)
+{
+  struct proc *p;
+
+  ptacquire();
+  if((p = findproc(pid)) != 0){
+    getstat(p, ps);
+    ptrelease();
+    return 0;
+  }
+  ptrelease();
+  return -1;
+}
+
+// Copy a snapshot of up to n in-use process table entries to
+// info and return how many were copied.
+// Doesn't take ptable.lock: it copies, then starts over if
+// ptable.seq shows the lock was held or taken meanwhile.
+// sz and name are changed by exec and sbrk without the lock,
+// so they may be a moment stale.
+int
+getprocs(struct procinfo *info, int n)
+{
+  struct proc *p;
+  struct procinfo *pi;
+  uint seq;
+  int i;
+
+  do {
+    while((seq = ptable.seq) & 1)
+      ;
+    __sync_synchronize();
+    i = 0;
+    for(p = ptable.proc; p < &ptable.proc[NPROC] && i < n; p++){
+      if(p->state == UNUSED)
+        continue;
+      pi = &info[i++];
+      pi->pid = p->pid;
+      pi->ppid = p->parent ? p->parent->pid : 0;
+      pi->state = p->state;
+      pi->priority = p->priority;
+      pi->nice = p->nice;
+      pi->procmtimes = p->procmtimes;
+      pi->running = p->running;
+      pi->cputicks = p->cputicks;
+      pi->cpu = p->lastcpu;
+      pi->sz = p->sz;
+      safestrcpy(pi->name, p->name, sizeof(pi->name));
+    }
+    __sync_synchronize();
+  } while(ptable.seq != seq);
+  return i;
+}
+
+// Copy the counters of up to n cpus to cs and return how
+// many were copied.  Each cpu updates its own counters without
+// a lock, so they may be a moment stale.
+int
+getcpustat(struct cpustat *cs, int n)
+{
+  struct cpu *c;
+  int i;
+
+  for(i = 0; i < n && i < ncpu; i++){
+    c = &cpus[i];
+    cs[i].id = c->id;
+    cs[i].nrunnable = c->nrunnable;
+    cs[i].idleticks = c->idleticks;
+    cs[i].busyticks = c->busyticks;
+    cs[i].steals = c->steals;
+    cs[i].stolen = c->stolen;
+    cs[i].cr3loads = c->cr3loads;
+    cs[i].cr3skips = c->cr3skips;
+  }
+  return i;
+}
+
+// Copy the current MLFQ parameters to *sp.
+void
+getsched(struct schedparam *sp)
+{
+  ptacquire();
+  *sp = mlfq;
+  ptrelease();
+}
+
+// Restrict the process with the given pid to the cpus whose
+// bits are set in mask.  A queued process moves to an allowed
+// cpu now; a running one when it next gives up its cpu, which
+// for the caller is right away.
+// Return -1 if there is no such process or mask allows no cpu.
+int
+setaffinity(int pid, uint mask)
+{
+  struct proc *p;
+  int self;
+
+  if(ncpu < 32)
+    mask &= (1 << ncpu) - 1;
+  if(mask == 0)
+    return -1;
+
+  ptacquire();
+  // Real-time processes stay on the cpu that admitted them.
+  if((p = findproc(pid)) == 0 || p->state == ZOMBIE || p->rtperiod){
+    ptrelease();
+    return -1;
+  }
+  p->affinity = mask;
+  if(p->onq && (mask & 1 << p->rqcpu->id) == 0){
+    cpuQueueRemove(p);
+    cpuQueuePush(placecpu(p), p);
+    resched(p->rqcpu);
+  }
+  self = p == proc && (mask & 1 << cpu->id) == 0;
+  ptrelease();
+
+  if(self)
+    relinquish(0);
+  return 0;
+}
+
+// Cpu share for each nice value, NICE_MIN first: each step
+// is about 1.25 times the next, so one nice step is worth about
+// 10% of the cpu between two busy processes.  Nice 0 is
+// 1 << NICE0SHIFT.
+#define NICE0SHIFT 10
+static int niceweight[NICE_MAX - NICE_MIN + 1] = {
+  88761, 71755, 56483, 46273, 36291,
+  29154, 23254, 18705, 14949, 11916,
+   9548,  7620,  6100,  4904,  3906,
+   3121,  2501,  1991,  1586,  1277,
+   1024,   820,   655,   526,   423,
+    335,   272,   215,   172,   137,
+    110,    87,    70,    56,    45,
+     36,    29,    23,    18,    15,
+};
+
+// Set p's nice value and the weight and tickets that follow.
+static void
+setnice(struct proc *p, int nice)
+{
+  p->nice = nice;
+  p->weight = niceweight[nice - NICE_MIN];
+  p->tickets = p->weight * DEFTICKETS / niceweight[-NICE_MIN];
+  if(p->tickets < 1)
+    p->tickets = 1;
+}
+
+// Set the nice value of the process with the given pid.
+// It takes effect when the process is next queued.
+// Return -1 if there is no such process or nice is out of range.
+int
+setpriority(int pid, int nice)
+{
+  struct proc *p;
+
+  if(nice < NICE_MIN || nice > NICE_MAX)
+    return -1;
+  ptacquire();
+  if((p = findproc(pid)) == 0 || p->state == ZOMBIE){
+    ptrelease();
+    return -1;
+  }
+  setnice(p, nice);
+  ptrelease();
+  return 0;
+}
+
+// Return the nice value of the process with the given pid,
+// or NICE_MIN-1 if there is no such process.
+int
+getpriority(int pid)
+{
+  struct proc *p;
+  int nice;
+
+  ptacquire();
+  if((p = findproc(pid)) == 0 || p->state == ZOMBIE)
+    nice = NICE_MIN-1;
+  else
+    nice = p->nice;
+  ptrelease();
+  return nice;
+}
+
+// Priority inheritance for sleeplocks.  A process about to
+// wait for a sleeplock whose holder is at a lower MLFQ level
+// lends the holder its level, so the holder isn't stuck behind
+// everything in between while the waiter waits.  The holder
+// keeps the loan until it releases its last exclusive sleeplock
+// (see releasesleep()); that may be a little longer than needed
+// if it holds several, but never too short.  Loans are not
+// passed on if the holder is itself waiting for another lock.
+
+// The level p is queued at: its own or one lent to it.
+static int
+runlevel(struct proc *p)
+{
+  return p->inherited < p->priority ? p->inherited : p->priority;
+}
+
+// Lend this process's level to owner, which holds a sleeplock
+// this process is about to wait for.  The caller holds that
+// sleeplock's spinlock, so owner can't let go meanwhile.
+// Returns 1 if owner was at a lower level: a priority inversion.
+int
+inheritprio(struct proc *owner)
+{
+  struct cpu *c;
+  int level;
+
+  ptacquire();
+  level = proc->rtperiod ? 0 : runlevel(proc);
+  if(owner->rtperiod || runlevel(owner) <= level){
+    ptrelease();
+    return 0;
+  }
+  owner->inherited = level;
+  if(owner->onq){
+    c = owner->rqcpu;
+    cpuQueueRemove(owner);
+    cpuQueuePush(c, owner);
+    resched(c);
+  }
+  ptrelease();
+  return 1;
+}
+
+// Give back any level lent to this process, which has released
+// its last exclusive sleeplock.  It is running, so not queued.
+void
+disinherit(void)
+{
+  ptacquire();
+  proc->inherited = NLEVEL;
+  ptrelease();
+}
+
+// Replace the scheduler parameters with *sp in one step.
+// Processes below the new lowest level move up to it.
+// A new policy takes over the queued processes as if they
+// had just been created.
+// Return -1 if a parameter is out of range.
+int
+setsched(struct schedparam *sp)
+{
+  struct proc *p;
+  struct cpu *c;
+  uint inuse;
+  int level;
+
+  if(sp->nlevels < 1 || sp->nlevels > NLEVEL)
+    return -1;
+  if(sp->demote < 1 || sp->boost < 1)
+    return -1;
+  if(sp->policy < 0 || sp->policy >= NSCHEDPOLICY)
+    return -1;
+  for(level = 0; level < NLEVEL; level++)
+    if(sp->quantum[level] < 1)
+      return -1;
+
+  ptacquire();
+  if(sp->policy != mlfq.policy){
+    policy = &schedops[sp->policy];
+    for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
+      p->priority = 0;
+      p->procmtimes = 0;
+      if(p->onq && p->rtperiod == 0){
+        c = p->rqcpu;
+        cpuQueueRemove(p);
+        p->quantum = 0;
+        policy->enqueue(c, p, ENQ_NEW);
       }
-      release(&ptable.lock);
-      return 0;
     }
   }
-  release(&ptable.lock);
+  mlfq = *sp;
+  inuse = (1 << mlfq.nlevels) - 1;
+  for(c = cpus; c < cpus+ncpu; c++){
+    for(level = mlfq.nlevels; level < NLEVEL; level++){
+      while(queueIsEmpty(&c->rq[level]) == 0){
+        p = c->rq[level].head;
+        dequeue(&c->rq[level]);
+        queuePush(&c->rq[mlfq.nlevels-1], p);
+      }
+    }
+    if(c->rqmask & ~inuse)
+      c->rqmask = (c->rqmask & inuse) | 1 << (mlfq.nlevels-1);
+  }
+  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++)
+    if(p->priority >= mlfq.nlevels)
+      p->priority = mlfq.nlevels-1;
+  ptrelease();
+  return 0;
+}
 
-  return -1;
+// Copy p's scheduling statistics to *ps, counting the time
+// since its last state change as waiting or sleeping.
+// The ptable lock must be held.
+static void
+getstat(struct proc *p, struct procstat *ps)
+{
+  memset(ps, 0, sizeof(*ps));
+  ps->version = PROCSTAT_VERSION;
+  ps->pid = p->pid;
+  ps->created = p->created;
+  ps->ended = p->ended;
+  ps->response = p->response;
+  ps->cputicks = p->cputicks;
+  ps->waitticks = p->waitticks;
+  ps->sleepticks = p->sleepticks;
+  if(p->state == RUNNABLE)
+    ps->waitticks += ticks - p->stamp;
+  else if(p->state == SLEEPING)
+    ps->sleepticks += ticks - p->stamp;
+  ps->dispatches = p->running;
+  ps->voluntary = p->voluntary;
+  ps->involuntary = p->involuntary;
+  memmove(ps->levelticks, p->levelticks, sizeof(ps->levelticks));
+  ps->migrations = p->migrations;
+  ps->rtmissed = p->rtmissed;
+  ps->rtthrottled = p->rtthrottled;
+  ps->inversions = p->inversions;
+  ps->invticks = p->invticks;
 }
 
 //PAGEBREAK: 36
@@ -610,9 +1434,17 @@ procdump(void)
   };
   int i;
   struct proc *p;
+  struct cpu *c;
   char *state;
   uint pc[10];
   
+  cprintf("policy %s\n", policy->name);
+  for(c = cpus; c < cpus+ncpu; c++)
+    cprintf("cpu%d: runnable %d steals %d stolen %d idle %d/%d ticks"
+            " cr3 loads %d skips %d\n",
+            c->id, c->nrunnable, c->steals, c->stolen,
+            c->idleticks, c->idleticks + c->busyticks,
+            c->cr3loads, c->cr3skips);
   for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
     if(p->state == UNUSED)
       continue;
@@ -637,24 +1469,14 @@ procdump(void)
 void
 queuePush(struct queue *q,struct proc *p)
 {
+	p->next = NULL;
+	p->previous = q->tail;
 	if(q->tail == NULL)
-	{
 		q->head = p;
-		q->tail = p;
-	}
-	else if (q->tail == q->head)
-	{		
+	else
 		q->tail->next = p;
-		p->previous= q->tail;
-		q->tail = p;
-		q->head->next = q->tail;
-	}
-	else {
-		q->tail->next = p;
-		p->previous= q->tail;
-		q->tail = p;
-		q->tail->next = NULL;
-	}
+	q->tail = p;
+	p->onq = q;
 }
 
 
@@ -680,122 +1502,583 @@ dequeue(struct queue *q){
 	if(queueIsEmpty(q) ){
 		return;
 	}
-	else if( q->head == q->tail){
-		q->head = NULL;
-		q->tail = NULL;
-	}
-	else if(q->head->next == q->tail){
-		q->head->next= NULL;
-		q->head = q->tail;
-		q->tail->previous = NULL;
-	}
-	else 
-	{
-		q->head = q->head->next;
-		q->head->previous->next = NULL;
-		q->head->previous = NULL;
-	}
+	queueRemove(q, q->head);
+}
+
+
+// unlink the process from q, wherever it is in the queue,
+// using its own next and previous pointers
+// the process must be on q
+void
+queueRemove(struct queue *q, struct proc *p){
+
+	if(p->previous == NULL)
+		q->head = p->next;
+	else
+		p->previous->next = p->next;
+	if(p->next == NULL)
+		q->tail = p->previous;
+	else
+		p->next->previous = p->previous;
+	p->next = NULL;
+	p->previous = NULL;
+	p->onq = NULL;
 }
 
 
-// loop through the med queue and move all the processes to the high queue
-// and loop through the low queue and move all the processes to the high queue
+// loop through every lower queue of c and move all the processes
+// to the high queue, keeping their order
 void
-moveToHighQ(struct queue *q1, struct queue *q2, struct queue *q3){
+moveToHighQ(struct cpu *c){
 
 	struct proc *p;
-	while(queueIsEmpty(q2)==0){
-		p = q2->head;
-		p->priority= 0;
-		p->procmtimes = 0;
-		queuePush(q1, p);
-		dequeue(q2);
+	int level;
+
+	for(level = 1; level < NLEVEL; level++){
+		while(queueIsEmpty(&c->rq[level])==0){
+			p = c->rq[level].head;
+			p->priority= 0;
+			p->procmtimes = 0;
+			p->quantum = 0;
+			dequeue(&c->rq[level]);
+			queuePush(&c->rq[0], p);
+		}
 	}
-	while(queueIsEmpty(q3)==0){
-		p = q3->head;
-		p->priority= 0;
-		p->procmtimes = 0;
-		queuePush(q1, p);
-		dequeue(q3);
+	if(c->rqmask != 0)
+		c->rqmask = 1;
+}
+
+
+
+// put the process at the tail of c's queue for its priority,
+// or a higher one lent to it, see inheritprio()
+// the ptable lock must be held
+static void
+cpuQueuePush(struct cpu *c, struct proc *p)
+{
+	queuePush(&c->rq[runlevel(p)], p);
+	c->rqmask |= 1 << runlevel(p);
+	c->nrunnable++;
+	p->rqcpu = c;
+}
+
+
+// take the process off whichever cpu's run queue it is on
+// in constant time; does nothing if it is not queued
+// the ptable lock must be held
+static void
+cpuQueueRemove(struct proc *p)
+{
+	struct cpu *c;
+	struct queue *q;
+
+	if((q = p->onq) == NULL)
+		return;
+	c = p->rqcpu;
+	trace(SE_DEQUEUE, p);
+	queueRemove(q, p);
+	if(q != &c->rtq && queueIsEmpty(q))
+		c->rqmask &= ~(1 << (q - c->rq));
+	c->nrunnable--;
+	p->rqcpu = NULL;
+}
+
+
+// remove and return the head of c's highest non-empty queue,
+// found from the lowest set bit of rqmask in constant time
+// return 0 if all the queues are empty
+// the ptable lock must be held
+static struct proc*
+cpuDequeue(struct cpu *c)
+{
+	struct queue *q;
+	struct proc *p;
+	int level;
+
+	if(c->rqmask == 0)
+		return 0;
+	level = bsf(c->rqmask);
+	q = &c->rq[level];
+	p = q->head;
+	trace(SE_DEQUEUE, p);
+	dequeue(q);
+	if(queueIsEmpty(q))
+		c->rqmask &= ~(1 << level);
+	c->nrunnable--;
+	p->rqcpu = NULL;
+	return p;
+}
+
+
+// choose the cpu whose queues p should go on: the cpu it last
+// ran on, whose cache may still be warm, else this cpu, else
+// the first cpu its affinity allows
+// the ptable lock must be held
+static struct cpu*
+placecpu(struct proc *p)
+{
+	struct cpu *c;
+
+	if(p->lastcpu >= 0 && (p->affinity & 1 << p->lastcpu))
+		return &cpus[p->lastcpu];
+	if(p->affinity & 1 << cpu->id)
+		return cpu;
+	for(c = cpus; c < cpus+ncpu; c++)
+		if(p->affinity & 1 << c->id)
+			return c;
+	panic("placecpu");
+}
+
+
+// the first process on c's queues, highest level first, whose
+// affinity allows it to run on this cpu
+// return 0 if there is none
+// the ptable lock must be held
+static struct proc*
+stealable(struct cpu *c)
+{
+	struct proc *p;
+	int level;
+
+	for(level = 0; level < NLEVEL; level++)
+		for(p = c->rq[level].head; p; p = p->next)
+			if(p->affinity & 1 << cpu->id)
+				return p;
+	return 0;
+}
+
+
+// take the next process this cpu may run from the sibling cpu
+// with the most queued processes, so an idle cpu can run it
+// return 0 if no other cpu has anything queued for us
+// the ptable lock must be held
+static struct proc*
+steal(void)
+{
+	struct cpu *c, *busiest;
+	struct proc *p, *victim;
+
+	busiest = 0;
+	victim = 0;
+	for(c = cpus; c < cpus+ncpu; c++){
+		if(c == cpu || c->nrunnable == 0)
+			continue;
+		if(busiest && c->nrunnable <= busiest->nrunnable)
+			continue;
+		if((p = stealable(c)) == 0)
+			continue;
+		busiest = c;
+		victim = p;
 	}
+	if(victim == 0)
+		return 0;
+	cpuQueueRemove(victim);
+	cpu->steals++;
+	busiest->stolen++;
+	return victim;
 }
 
 
+// count the processes queued on all cpus
+// reads the counters without the ptable lock, so the
+// answer is only a hint for the idle loop in scheduler()
+static int
+runnable(void)
+{
+	struct cpu *c;
+	int n;
 
-// search through the queue and remove the process from it
-void
-removeFromQueue(struct proc *p, struct queue *q1, struct queue *q2, struct queue *q3){
+	n = 0;
+	for(c = cpus; c < cpus+ncpu; c++)
+		n += c->nrunnable;
+	return n;
+}
 
-	struct proc *delP;
-	if(p->priority == 0 && queueIsEmpty(q1)== 0){
-		if(p->pid == q1->head->pid) {
-			dequeue(q1);
-		}
-		else if ( q1->head->next == q1->tail) {
-			if(q1->tail->pid == p->pid)
-			{
-				q1->head->next= NULL;
-				q1->tail = q1->head;
-				q1->tail->previous = NULL;
-			}	
-		}
-		else {
-			delP = q1->head->next;
-			while(p->pid != delP->pid && delP->next != NULL){
-				delP = delP->next;
-			}
-			delP->next->previous = delP->previous;
-			delP->previous->next = delP->next;
-			delP->priority = 0;
-			delP->procmtimes = 0;
-			
-		}
+
+// halt this cpu until an interrupt arrives, unless something
+// was queued since scheduler() looked
+// cpu->idle is set before the last look, so a cpu that queues
+// work after it will see the flag and send us an IPI
+static void
+idle(void)
+{
+	cli();
+	xchg(&cpu->idle, 1);
+	if(runnable() == 0)
+		stihlt();
+	cpu->idle = 0;
+	sti();
+}
+
+
+// send a reschedule IPI to wake a halted cpu for the work just
+// queued on cpu to: to itself if it is halted, else any other
+// halted cpu, which can steal the work
+// the ptable lock must be held
+static void
+resched(struct cpu *to)
+{
+	struct cpu *c;
+
+	// order the queue update before reading the idle flags
+	__sync_synchronize();
+	if(to != cpu && to->idle){
+		lapicipi(to->id, T_IRQ0 + IRQ_RESCHED);
+		return;
 	}
-	else if(p->priority == 1 && queueIsEmpty(q2)== 0){
-		if(p->pid == q2->head->pid )  {
-			dequeue(q2);
-		}
-		else if ( q2->head->next == q2->tail){
-			if(q2->tail->pid ==p->pid) {
-				q2->head->next = NULL;
-				q2->tail = q2->head;
-				q2->tail->previous = NULL;
-			}
-		}
-		else {
-			delP = q2->head->next;
-			while( p->pid != delP->pid && delP->next != NULL){
-				delP= delP->next;
-			}
-			delP->next->previous = delP->previous;
-			delP->previous->next = delP->next;
-			delP->priority = 0;
-			delP->procmtimes = 0;
+	for(c = cpus; c < cpus+ncpu; c++){
+		if(c != cpu && c != to && c->idle){
+			lapicipi(c->id, T_IRQ0 + IRQ_RESCHED);
+			return;
 		}
 	}
-	else if(p->priority == 2 && queueIsEmpty(q3)== 0){
-		if(p->pid == q3->head->pid ){
-			dequeue(q3);
+}
 
-		}
-		else if (q3->head->next == q3->tail) {
-			if(q3->tail->pid == p->pid) {
-				q3->head->next = NULL;
-				q3->tail = q3->head;
-				q3->tail->previous = NULL;
-			}
-		}
-		else {
-			delP = q3->head->next;
-			while(p->pid != delP->pid && delP->next != NULL){
-				delP= delP->next;
-			}
-			delP->next->previous = delP->previous;
-			delP->previous->next = delP->next;
-			delP->priority = 0;
-			delP->procmtimes = 0;
-		}
-	}
+//PAGEBREAK!
+// Real-time class: earliest deadline first, above the policy.
+// A real-time process declares (runtime, period, deadline) with
+// setrt().  Each job is released when the process wakes at
+// least period ticks after the last release; woken sooner, it
+// waits for that release (see wakeproc()).  The job gets
+// runtime ticks of cpu and must finish (sleep) by its deadline.
+// Admission keeps the sum of runtime/deadline on each cpu under
+// RTDENSITY, so EDF can meet every deadline there.  Real-time
+// processes are never stolen.  A job that uses up its runtime
+// sleeps until its next release, so the class can't starve the
+// rest of the system.
+
+// Start p's next job now.
+static void
+rt_release(struct proc *p)
+{
+  p->rtbudget = p->rtruntime;
+  p->rtabsdl = ticks + p->rtdeadline;
+  p->rtnext = ticks + p->rtperiod;
+  p->rtdone = 0;
+}
+
+// Count a miss if p's job is still unfinished past its deadline.
+// Also called when the job finishes, which then marks it done.
+static void
+rt_late(struct proc *p)
+{
+  if(!p->rtdone && (int)(ticks - p->rtabsdl) > 0){
+    p->rtmissed++;
+    p->rtdone = 1;
+  }
+}
+
+// Queue real-time p on its cpu's rtq in deadline order.
+// The ptable lock must be held.
+static void
+rt_enqueue(struct proc *p, int why)
+{
+  struct cpu *c;
+  struct queue *q;
+  struct proc *q1;
+
+  // wakeproc() holds p back until its release unless it was
+  // killed; either way it gets a fresh deadline, never the
+  // finished job's.
+  if(why == ENQ_WAKE)
+    rt_release(p);
+
+  c = &cpus[p->rtcpu];
+  q = &c->rtq;
+  for(q1 = q->head; q1; q1 = q1->next)
+    if((int)(p->rtabsdl - q1->rtabsdl) < 0)
+      break;
+  if(q1 == 0){
+    queuePush(q, p);
+  } else {
+    p->next = q1;
+    p->previous = q1->previous;
+    if(q1->previous)
+      q1->previous->next = p;
+    else
+      q->head = p;
+    q1->previous = p;
+    p->onq = q;
+  }
+  c->nrunnable++;
+  p->rqcpu = c;
 }
 
+// A timer tick of running real-time process p.
+// Called from trap() without locks, in p's context.
+static int
+rt_tick(struct proc *p)
+{
+  struct proc *q;
+
+  rt_late(p);
+  if(--p->rtbudget <= 0){
+    // Out of runtime: wait for the next release.  Sleeps on
+    // its own channel so that only rtwakeup() wakes it, once,
+    // rather than every tick putting it back on rtq with the
+    // past deadline at the head.
+    p->rtthrottled++;
+    ptacquire();
+    while((int)(ticks - p->rtnext) < 0 && !p->killed)
+      sleep(&p->rtnext, &ptable.lock);
+    ptrelease();
+    return 0;
+  }
+  // Racy, like the rtq check in schedtick().
+  q = cpu->rtq.head;
+  return q != 0 && (int)(q->rtabsdl - p->rtabsdl) < 0;
+}
+
+// Wake the throttled real-time processes whose next release
+// has come.  Called by the timer interrupt after ticks advances.
+// A woken process is interrupted onto its cpu right away rather
+// than at that cpu's next tick.
+void
+rtwakeup(void)
+{
+  struct proc *p;
+  struct cpu *c;
+
+  // Racy, but a process that throttles meanwhile is checked
+  // again next tick, before its release is due.
+  if(ptable.nthrottled == 0)
+    return;
+  ptacquire();
+  for(p = ptable.proc; p < &ptable.proc[NPROC]; p++){
+    if(p->state != SLEEPING || p->chan != &p->rtnext)
+      continue;
+    if((int)(ticks - p->rtnext) < 0)
+      continue;
+    wakeproc(p);
+    c = &cpus[p->rtcpu];
+    if(c != cpu && !c->idle)
+      lapicipi(c->id, T_IRQ0 + IRQ_RESCHED);
+  }
+  ptrelease();
+}
+
+// Should running p give way to a real-time job queued on this
+// cpu?  For a resched interrupt from rtwakeup().
+int
+rtpreempt(struct proc *p)
+{
+  struct proc *q;
+
+  // Racy, like the rtq check in schedtick().
+  q = cpu->rtq.head;
+  if(q == 0)
+    return 0;
+  return p->rtperiod == 0 || (int)(q->rtabsdl - p->rtabsdl) < 0;
+}
+
+// Make the calling process real-time with the given runtime,
+// period and deadline in ticks, or an ordinary process again
+// if runtime is 0.  It moves to the cpu with the least
+// real-time load that can admit it.
+// Return -1 if the parameters are bad or no cpu has room.
+int
+setrt(int runtime, int period, int deadline)
+{
+  struct cpu *c, *best;
+  int density;
+
+  if(runtime < 0 || (runtime > 0 &&
+     (runtime > deadline || deadline > period)))
+    return -1;
+
+  ptacquire();
+  if(proc->rtperiod){
+    cpus[proc->rtcpu].rtdensity -= proc->rtdensity;
+    proc->rtperiod = 0;
+  }
+  if(runtime == 0){
+    ptrelease();
+    return 0;
+  }
+
+  density = runtime * 1000 / deadline;
+  best = 0;
+  for(c = cpus; c < cpus+ncpu; c++){
+    if(c->rtdensity + density > RTDENSITY)
+      continue;
+    if(best == 0 || c->rtdensity < best->rtdensity)
+      best = c;
+  }
+  if(best == 0){
+    ptrelease();
+    return -1;
+  }
+  best->rtdensity += density;
+  proc->rtruntime = runtime;
+  proc->rtperiod = period;
+  proc->rtdeadline = deadline;
+  proc->rtdensity = density;
+  proc->rtcpu = best - cpus;
+  rt_release(proc);
+  ptrelease();
+
+  // Get onto the admitting cpu's rtq.
+  relinquish(0);
+  return 0;
+}
+
+//PAGEBREAK!
+// Scheduling policies; see struct schedops.
+
+// Use up one tick of p's time slice.
+static int
+quantumtick(struct proc *p)
+{
+  return --p->quantum <= 0;
+}
+
+// Scale a time slice by p's weight, so that processes taking
+// turns on one queue share the cpu in proportion to weight.
+// In 64 bits, since setsched() allows quanta large enough to
+// overflow the product; the result is clamped to an int.
+static int
+weighted(int quantum, struct proc *p)
+{
+  uint64 q;
+
+  q = (uint64)quantum * p->weight >> NICE0SHIFT;
+  if(q > 0x7fffffff)
+    return 0x7fffffff;
+  return q < 1 ? 1 : q;
+}
+
+// The high queue's time slice, for policies that share the
+// cpu by tickets rather than by slice length.
+static int
+plain_slice(struct proc *p)
+{
+  return mlfq.quantum[0];
+}
+
+// Round robin: one queue and the high queue's time slice,
+// scaled by weight.
+static void
+rr_enqueue(struct cpu *c, struct proc *p, int why)
+{
+  p->priority = 0;
+  cpuQueuePush(c, p);
+}
+
+static int
+rr_slice(struct proc *p)
+{
+  return weighted(mlfq.quantum[0], p);
+}
+
+// Multi-level feedback queue: new and woken processes go on
+// the queue for their nice value (the high queue unless they
+// are nice), processes that use up their time slices move
+// down, and boosts move everything back up.  Time slices are
+// scaled by weight.
+static void
+mlfq_enqueue(struct cpu *c, struct proc *p, int why)
+{
+  if(why != ENQ_YIELD){
+    p->priority = 0;
+    if(p->nice > 0)
+      p->priority = p->nice * mlfq.nlevels / (NICE_MAX+1);
+  } else if(p->quantum <= 0){
+    // Only a process that used up its time slice is demoted.
+    // One slice in the high queue moves it down a level;
+    // below that it takes mlfq.demote slices to move down again.
+    if(p->priority >= mlfq.nlevels-1){
+      p->procmtimes++;
+    } else if(p->priority == 0 || ++p->procmtimes >= mlfq.demote){
+      p->priority++;
+      p->procmtimes = 0;
+      trace(SE_DEMOTE, p);
+    }
+  }
+  cpuQueuePush(c, p);
+}
+
+static int
+mlfq_slice(struct proc *p)
+{
+  return weighted(mlfq.quantum[runlevel(p)], p);
+}
+
+// Stride scheduling: a process's pass advances by its stride,
+// STRIDE1/tickets, for every tick it runs, and the lowest pass
+// runs next, so cpu time is shared in proportion to tickets.
+// stridevtime is the highest pass picked so far; new and woken
+// processes start there rather than catching up on time they
+// weren't runnable.  Passes are compared by signed difference
+// so they can wrap.
+#define STRIDE1 (1<<16)
+static uint stridevtime;
+
+static void
+stride_enqueue(struct cpu *c, struct proc *p, int why)
+{
+  p->priority = 0;
+  if(why != ENQ_YIELD && (int)(p->pass - stridevtime) < 0)
+    p->pass = stridevtime;
+  cpuQueuePush(c, p);
+}
+
+static struct proc*
+stride_pick(struct cpu *c)
+{
+  struct proc *p, *best;
+
+  best = 0;
+  for(p = c->rq[0].head; p; p = p->next)
+    if(best == 0 || (int)(p->pass - best->pass) < 0)
+      best = p;
+  if(best == 0)
+    return 0;
+  cpuQueueRemove(best);
+  if((int)(best->pass - stridevtime) > 0)
+    stridevtime = best->pass;
+  return best;
+}
+
+static int
+stride_tick(struct proc *p)
+{
+  p->pass += STRIDE1 / p->tickets;
+  return quantumtick(p);
+}
+
+// Lottery scheduling: draw one of the tickets held by c's
+// queued processes; its holder runs next.
+static uint lotteryseed = 1;
+
+static struct proc*
+lottery_pick(struct cpu *c)
+{
+  struct proc *p;
+  uint total, n;
+
+  total = 0;
+  for(p = c->rq[0].head; p; p = p->next)
+    total += p->tickets;
+  if(total == 0)
+    return 0;
+  lotteryseed = lotteryseed * 1103515245 + 12345;
+  n = (lotteryseed >> 16) % total;
+  for(p = c->rq[0].head; p->next; p = p->next){
+    if(n < p->tickets)
+      break;
+    n -= p->tickets;
+  }
+  cpuQueueRemove(p);
+  return p;
+}
 
+static struct schedops schedops[NSCHEDPOLICY] = {
+[SCHED_RR]      { "rr", rr_enqueue, cpuQueueRemove, cpuDequeue,
+                  rr_slice, quantumtick, 0 },
+[SCHED_MLFQ]    { "mlfq", mlfq_enqueue, cpuQueueRemove, cpuDequeue,
+                  mlfq_slice, quantumtick, moveToHighQ },
+[SCHED_STRIDE]  { "stride", stride_enqueue, cpuQueueRemove, stride_pick,
+                  plain_slice, stride_tick, 0 },
+[SCHED_LOTTERY] { "lottery", rr_enqueue, cpuQueueRemove, lottery_pick,
+                  plain_slice, quantumtick, 0 },
+};
@@ -1,6 +1,13 @@
 // Segments in proc->gdt.
 #define NSEGS     7
 
+// added a struct for the queues 
+struct queue {
+
+	struct proc* head;		// a pointer to point to the head of the queue
+	struct proc* tail;		// a pointer to point to the tail of the queue
+};
+
 // Per-CPU state
 struct cpu {
   uchar id;                    // Local APIC ID; index into cpus[] below
@@ -10,6 +17,25 @@ struct cpu {
   volatile uint started;       // Has the CPU started?
   int ncli;                    // Depth of pushcli nesting.
   int intena;                  // Were interrupts enabled before pushcli?
+
+  // MLFQ run queues owned by this cpu, protected by ptable.lock
+  struct queue rq[NLEVEL];     // One queue per priority level
+  uint rqmask;                 // Bit i is set when rq[i] is non-empty
+  volatile int nrunnable;      // Number of processes on the queues
+  uint lastboost;              // ticks at the last moveToHighQ() of rq
+  volatile uint idle;          // Halted in scheduler() with nothing to run
+  uint idleticks;              // Timer ticks that found this cpu idle
+  uint busyticks;              // Timer ticks that found this cpu busy
+  uint steals;                 // Processes taken from a sibling's queues
+  uint stolen;                 // Processes siblings took from our queues
+  struct queue rtq;            // Real-time processes, earliest deadline first
+  int rtdensity;               // Real-time load admitted here, per mille
+  // Cycles from enqueue to dispatch, by level (NLEVEL is real-time)
+  uint lathist[NLEVEL+1][LATBUCKETS]; // Bucket i: 2^i to 2^(i+1)-1
+  uint latmax[NLEVEL+1];       // Longest, saturating
+  pde_t *pgdir;                // Page table loaded in cr3
+  uint cr3loads;               // cr3 loads, each a user TLB flush
+  uint cr3skips;               // Switches that found pgdir already loaded
   
   // Cpu-local storage variables; see below
   struct cpu *cpu;
@@ -58,10 +84,18 @@ struct proc {
   char *kstack;                // Bottom of kernel stack for this process
   enum procstate state;        // Process state
   int pid;                     // Process ID
+  struct proc *pidnext;        // Next process in the same pid hash bucket
+  struct proc *freenext;       // Next UNUSED slot on the free list
   struct proc *parent;         // Parent process
+  struct proc *children;       // Live children, linked by sibling
+  struct proc *zombies;        // Exited children not yet waited for
+  struct proc *sibling;        // Next process on the parent's list
+  struct proc **psibling;      // Link that points to this process
   struct trapframe *tf;        // Trap frame for current syscall
   struct context *context;     // swtch() here to run process
   void *chan;                  // If non-zero, sleeping on chan
+  struct proc *chnext;         // Next sleeper in chan's sleepq bucket
+  struct proc **chprev;        // Link that points to this sleeper
   int killed;                  // If non-zero, have been killed
   struct file *ofile[NOFILE];  // Open files
   struct inode *cwd;           // Current directory
@@ -72,15 +106,47 @@ struct proc {
 
   struct proc* next;			// pointer to point to next process
   struct proc* previous;		// pointer to point to previous process
-  int priority;			// pointer of process for queue, 0 is high , 1 is medium, 2 is low
+  struct queue* onq;			// run queue the process is on, 0 if none
+  struct cpu* rqcpu;			// cpu that owns onq
+  int priority;			// level of the process's queue, 0 is high, mlfq.nlevels-1 is low
   int procmtimes;
-};
+  int quantum;			// ticks left in the time slice, 0 to start a new one
+  int lastcpu;			// id of the cpu it is running on or last ran on
+  uint affinity;			// bit i set if it may run on cpus[i]
+  int nice;			// NICE_MIN to NICE_MAX, see setpriority()
+  int weight;			// cpu share for its nice value, 1024 at nice 0
+  int tickets;			// share under the stride and lottery policies
+  uint pass;			// stride policy's virtual time, see stride_pick()
+  uint64 enqtsc;			// rdtsc() when it was last queued
+  int inherited;			// level lent by a sleeplock waiter, NLEVEL if none
+  int nsleeplocks;			// sleeplocks it holds exclusively
+  struct sleeplock *shared[NSHARED];	// sleeplocks it holds shared, or 0
 
-// added a struct for the queues 
-struct queue {
+  // real-time class, see setrt(); rtperiod is 0 if not real-time
+  int rtruntime;			// ticks of cpu per job
+  int rtperiod;			// min ticks between job releases
+  int rtdeadline;			// ticks from release to deadline
+  int rtcpu;			// cpus[] index it was admitted on
+  int rtdensity;			// rtruntime/rtdeadline, per mille
+  int rtbudget;			// ticks left for this job
+  uint rtabsdl;			// this job's deadline
+  uint rtnext;			// earliest release of the next job
+  int rtdone;			// this job finished or its miss is counted
 
-	struct proc* head;		// a pointer to point to the head of the queue
-	struct proc* tail;		// a pointer to point to the tail of the queue
+  // scheduling statistics, see struct procstat
+  uint stamp;			// ticks when it last became runnable or slept
+  uint response;
+  uint cputicks;
+  uint waitticks;
+  uint sleepticks;
+  uint voluntary;
+  uint involuntary;
+  uint levelticks[NLEVEL];
+  uint migrations;
+  uint rtmissed;
+  uint rtthrottled;
+  uint inversions;
+  uint invticks;
 };
 
 
@@ -0,0 +1,104 @@
+// Parallel read benchmark.  Writes a file, then starts nproc
+// processes (one per cpu by default), each pinned to a cpu, that
+// open it and read it through the given number of times.  Prints
+// how long each took and the total read rate.  With shared inode
+// locks the readers only contend for the buffers they read.
+//   rdbench [nproc [rounds]]
+
+#include "param.h"
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fcntl.h"
+#include "sched.h"
+
+#define DATAFILE "rdbench.dat"
+#define NBLOCK 64
+
+struct cpustat cs[NCPU];
+char buf[512];
+
+int
+main(int argc, char *argv[])
+{
+  int ncpu, nproc, rounds, fd, i, n, r, total;
+  int start[2], result[2];
+  uint t0, t;
+  char c;
+
+  ncpu = getcpustat(cs, NCPU);
+  nproc = ncpu;
+  rounds = 20;
+  if(argc > 1)
+    nproc = atoi(argv[1]);
+  if(argc > 2)
+    rounds = atoi(argv[2]);
+  if(nproc < 1 || nproc > NPROC/2 || rounds < 1){
+    printf(2, "usage: rdbench [nproc [rounds]]\n");
+    exit();
+  }
+
+  fd = open(DATAFILE, O_CREATE|O_RDWR);
+  if(fd < 0){
+    printf(2, "rdbench: cannot create %s\n", DATAFILE);
+    exit();
+  }
+  memset(buf, 'r', sizeof(buf));
+  for(i = 0; i < NBLOCK; i++){
+    if(write(fd, buf, sizeof(buf)) != sizeof(buf)){
+      printf(2, "rdbench: write failed\n");
+      exit();
+    }
+  }
+  close(fd);
+
+  if(pipe(start) < 0 || pipe(result) < 0){
+    printf(2, "rdbench: pipe failed\n");
+    exit();
+  }
+  for(i = 0; i < nproc; i++){
+    n = fork();
+    if(n < 0){
+      printf(2, "rdbench: fork failed\n");
+      exit();
+    }
+    if(n == 0){
+      setaffinity(getpid(), 1 << (i % ncpu));
+      // Each opens the file itself so that its reads can
+      // share the inode lock; see fileread().
+      if((fd = open(DATAFILE, O_RDONLY)) < 0)
+        exit();
+      read(start[0], &c, 1);
+      t = uptime();
+      for(r = 0; r < rounds; r++){
+        while(read(fd, buf, sizeof(buf)) > 0)
+          ;
+        close(fd);
+        fd = open(DATAFILE, O_RDONLY);
+      }
+      close(fd);
+      t = uptime() - t;
+      write(result[1], &t, sizeof(t));
+      exit();
+    }
+  }
+
+  // Start them all at once.
+  t0 = uptime();
+  for(i = 0; i < nproc; i++)
+    write(start[1], "x", 1);
+  for(i = 0; i < nproc; i++){
+    if(read(result[0], &t, sizeof(t)) != sizeof(t))
+      break;
+    printf(1, "proc %d: %d ticks\n", i, t);
+  }
+  for(i = 0; i < nproc; i++)
+    wait();
+  t = uptime() - t0;
+  unlink(DATAFILE);
+
+  total = nproc * rounds * NBLOCK / 2;
+  printf(1, "%d procs on %d cpus read %d KB in %d ticks, %d KB per tick\n",
+         nproc, ncpu, total, t, t ? total / t : total);
+  exit();
+}
@@ -0,0 +1,68 @@
+// Time fork/exit/wait round trips as the process table fills.
+// Idle children blocked on a pipe take up table slots; the
+// time to reap a child should not grow with their number.
+
+#include "param.h"
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+
+#define ROUNDS  200   // fork/exit/wait round trips per fill level
+#define STEP     8    // idle children added per fill level
+
+int
+main(void)
+{
+  int fds[2], filled, pid, i, start;
+  char c;
+
+  if(pipe(fds) < 0){
+    printf(2, "reaptest: pipe failed\n");
+    exit();
+  }
+
+  printf(1, "reap test\n");
+  printf(1, "idle\tticks for %d reaps\n", ROUNDS);
+  for(filled = 0; filled + STEP + 4 < NPROC; filled += STEP){
+    // Add STEP more idle children that sit in read()
+    // until the pipe's write end is closed.
+    if(filled > 0){
+      for(i = 0; i < STEP; i++){
+        pid = fork();
+        if(pid < 0){
+          printf(2, "reaptest: fork failed\n");
+          exit();
+        }
+        if(pid == 0){
+          close(fds[1]);
+          read(fds[0], &c, 1);
+          exit();
+        }
+      }
+    }
+
+    start = uptime();
+    for(i = 0; i < ROUNDS; i++){
+      pid = fork();
+      if(pid < 0){
+        printf(2, "reaptest: fork failed\n");
+        exit();
+      }
+      if(pid == 0)
+        exit();
+      if(wait() != pid){
+        printf(2, "reaptest: wait got the wrong child\n");
+        exit();
+      }
+    }
+    printf(1, "%d\t%d\n", filled, uptime() - start);
+  }
+
+  // Release the idle children and reap them.
+  close(fds[1]);
+  close(fds[0]);
+  while(wait() >= 0)
+    ;
+  printf(1, "reap test OK\n");
+  exit();
+}
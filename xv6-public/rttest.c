@@ -0,0 +1,79 @@
+// Run a periodic control loop next to cpu hogs, first as an
+// ordinary process and then as a real-time one, and report how
+// long each period's work took from its release.
+// rttest [hogs]
+
+#include "param.h"
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "sched.h"
+
+#define PERIODS   50    // periods per run
+#define PERIOD    10    // ticks between releases
+#define DEADLINE   5    // ticks from release to deadline
+#define RUNTIME    2    // ticks of cpu per period
+#define WORK  100000    // loop iterations of work per period
+
+volatile int sink;
+
+void
+run(char *name)
+{
+  struct procstat ps;
+  int i, j, release, late, worst, total;
+
+  worst = total = 0;
+  for(i = 0; i < PERIODS; i++){
+    release = uptime();
+    for(j = 0; j < WORK; j++)
+      sink += j;
+    late = uptime() - release;
+    total += late;
+    if(late > worst)
+      worst = late;
+    if(release + PERIOD > uptime())
+      sleep(release + PERIOD - uptime());
+  }
+  getprocstat(getpid(), &ps);
+  printf(1, "%s: %d ticks in %d periods, worst %d, missed %d throttled %d\n",
+         name, total, PERIODS, worst, ps.rtmissed, ps.rtthrottled);
+}
+
+int
+main(int argc, char *argv[])
+{
+  int hogs, i, pids[NPROC];
+
+  hogs = 4;
+  if(argc > 1)
+    hogs = atoi(argv[1]);
+  if(hogs < 0 || hogs > NPROC/2){
+    printf(2, "usage: rttest [hogs]\n");
+    exit();
+  }
+
+  for(i = 0; i < hogs; i++){
+    if((pids[i] = fork()) < 0){
+      printf(2, "rttest: fork failed\n");
+      hogs = i;
+      break;
+    }
+    if(pids[i] == 0)
+      for(;;)
+        sink++;
+  }
+
+  run("ordinary");
+  if(setrt(RUNTIME, PERIOD, DEADLINE) < 0)
+    printf(2, "rttest: setrt refused\n");
+  else
+    run("real-time");
+  setrt(0, 0, 0);
+
+  for(i = 0; i < hogs; i++)
+    kill(pids[i]);
+  for(i = 0; i < hogs; i++)
+    wait();
+  exit();
+}
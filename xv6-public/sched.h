@@ -0,0 +1,107 @@
+// Scheduler structures shared by the kernel and user programs.
+// Uses NLEVEL from param.h.
+
+// Scheduling policies, selected by schedparam.policy.
+#define SCHED_RR       0   // Round robin, quantum[0] ticks per slice
+#define SCHED_MLFQ     1   // Multi-level feedback queue
+#define SCHED_STRIDE   2   // Stride scheduling by tickets
+#define SCHED_LOTTERY  3   // Lottery scheduling by tickets
+#define NSCHEDPOLICY   4
+
+// Range of nice values set by setpriority().  Higher is nicer:
+// a later start in the MLFQ and a smaller share of the cpu.
+#define NICE_MIN     (-20)
+#define NICE_MAX      19
+
+// Scheduler parameters read and set by getsched() and setsched().
+struct schedparam {
+  int nlevels;          // Priority levels in use, 1 to NLEVEL
+  int quantum[NLEVEL];  // Time slice in ticks at each level
+  int demote;           // Used-up slices at a level before moving down
+  int boost;            // Ticks between boosts to the high queue
+  int policy;           // SCHED_RR ... SCHED_LOTTERY
+};
+
+#define PROCSTAT_VERSION 4
+
+// Per-process scheduling statistics filled in by waitstat2()
+// and getprocstat().  Times are in timer ticks.
+struct procstat {
+  int version;          // PROCSTAT_VERSION of the kernel that filled it
+  int pid;
+  uint created;         // When the process was allocated
+  uint ended;           // When it exited, 0 if it is still running
+  uint response;        // From creation to first dispatch
+  uint cputicks;        // Running on a cpu
+  uint waitticks;       // Runnable, waiting on a run queue
+  uint sleepticks;      // Sleeping
+  uint dispatches;      // Times the scheduler picked it
+  uint voluntary;       // Switches away because it slept
+  uint involuntary;     // Switches away because it was preempted
+  uint levelticks[NLEVEL]; // Running at each MLFQ level
+  uint migrations;      // Dispatches on a different cpu than the last
+  uint rtmissed;        // Real-time jobs still unfinished at their deadline
+  uint rtthrottled;     // Real-time jobs that used up their runtime
+  uint inversions;      // Waits for a sleeplock held at a lower MLFQ level
+  uint invticks;        // Ticks spent in those waits
+};
+
+// One cpu's wakeup-to-run latency histograms, copied out by
+// getlatency(): cycles from a process being queued (created,
+// woken or preempted) to its dispatch.  Row NLEVEL is the
+// real-time class; the others are MLFQ levels.
+struct latstat {
+  int cpu;
+  uint hist[NLEVEL+1][LATBUCKETS]; // Bucket i: 2^i to 2^(i+1)-1 cycles
+  uint max[NLEVEL+1];              // Longest, saturating at 2^32-1
+};
+
+// Scheduler trace events, read in binary from the schedtrace
+// device (major 2) once tracing is turned on by writing '1' to it.
+#define SE_ENQUEUE   1    // queued on a run queue
+#define SE_DEQUEUE   2    // taken off a run queue
+#define SE_DISPATCH  3    // started running
+#define SE_PREEMPT   4    // gave up its cpu while runnable
+#define SE_DEMOTE    5    // moved down an MLFQ level
+#define SE_BOOST     6    // cpu's queues boosted; pid is 0
+#define SE_SLEEP     7    // went to sleep
+#define SE_WAKEUP    8    // woken up
+#define SE_EXIT      9    // exited
+#define SE_DROPPED  10    // ring was full; pid is events lost
+
+struct schedevent {
+  uint64 tsc;           // rdtsc() on the recording cpu
+  int pid;
+  uchar type;           // SE_ENQUEUE ... SE_DROPPED
+  uchar cpu;            // Recording cpu
+  uchar level;          // MLFQ level, or NLEVEL if real-time
+  uchar pad;
+};
+
+// One cpu's counters copied out by getcpustat().
+struct cpustat {
+  int id;               // Local APIC ID
+  int nrunnable;        // Processes on its run queues
+  uint idleticks;       // Timer ticks that found it idle
+  uint busyticks;       // Timer ticks that found it busy
+  uint steals;          // Processes it took from a sibling's queues
+  uint stolen;          // Processes siblings took from its queues
+  uint cr3loads;        // Page table loads, each a user TLB flush
+  uint cr3skips;        // Switches that found the page table loaded
+};
+
+// One process in the snapshot copied out by getprocs().
+struct procinfo {
+  int pid;
+  int ppid;             // Parent's pid, 0 for init
+  int state;            // enum procstate in proc.h: 2 sleeping,
+                        // 3 runnable, 4 running, 5 zombie
+  int priority;         // MLFQ level
+  int nice;             // NICE_MIN to NICE_MAX
+  int procmtimes;       // Used-up slices at that level
+  uint running;         // Times dispatched
+  uint cputicks;        // Ticks spent running
+  int cpu;              // Cpu it is running on or last ran on
+  uint sz;              // Size of process memory (bytes)
+  char name[16];
+};
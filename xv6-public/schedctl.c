@@ -0,0 +1,79 @@
+// Read or change the scheduler parameters of the running kernel.
+//   schedctl                    print the current parameters
+//   schedctl levels 4 boost 100 quantum 3 16 demote 5
+//   schedctl policy stride      switch to another policy
+
+#include "param.h"
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "sched.h"
+
+char *policies[NSCHEDPOLICY] = {
+[SCHED_RR]      "rr",
+[SCHED_MLFQ]    "mlfq",
+[SCHED_STRIDE]  "stride",
+[SCHED_LOTTERY] "lottery",
+};
+
+void
+usage(void)
+{
+  printf(2, "usage: schedctl [levels n] [quantum level ticks] "
+            "[demote n] [boost ticks] [policy rr|mlfq|stride|lottery]...\n");
+  exit();
+}
+
+int
+policy(char *name)
+{
+  int i;
+
+  for(i = 0; i < NSCHEDPOLICY; i++)
+    if(strcmp(name, policies[i]) == 0)
+      return i;
+  usage();
+  return -1;
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct schedparam sp;
+  int i, level;
+
+  if(getsched(&sp) < 0){
+    printf(2, "schedctl: getsched failed\n");
+    exit();
+  }
+
+  for(i = 1; i < argc; i++){
+    if(strcmp(argv[i], "levels") == 0 && i+1 < argc){
+      sp.nlevels = atoi(argv[++i]);
+    } else if(strcmp(argv[i], "quantum") == 0 && i+2 < argc){
+      level = atoi(argv[++i]);
+      if(level < 0 || level >= NLEVEL)
+        usage();
+      sp.quantum[level] = atoi(argv[++i]);
+    } else if(strcmp(argv[i], "demote") == 0 && i+1 < argc){
+      sp.demote = atoi(argv[++i]);
+    } else if(strcmp(argv[i], "boost") == 0 && i+1 < argc){
+      sp.boost = atoi(argv[++i]);
+    } else if(strcmp(argv[i], "policy") == 0 && i+1 < argc){
+      sp.policy = policy(argv[++i]);
+    } else {
+      usage();
+    }
+  }
+
+  if(argc > 1 && setsched(&sp) < 0){
+    printf(2, "schedctl: bad parameters\n");
+    exit();
+  }
+
+  printf(1, "policy %s\n", policies[sp.policy]);
+  printf(1, "levels %d demote %d boost %d\n", sp.nlevels, sp.demote, sp.boost);
+  for(level = 0; level < sp.nlevels; level++)
+    printf(1, "level %d quantum %d\n", level, sp.quantum[level]);
+  exit();
+}
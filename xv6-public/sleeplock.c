@@ -0,0 +1,196 @@
+// Sleeping locks
+
+#include "types.h"
+#include "defs.h"
+#include "param.h"
+#include "x86.h"
+#include "memlayout.h"
+#include "mmu.h"
+#include "proc.h"
+#include "spinlock.h"
+#include "sleeplock.h"
+
+// How many times acquiresleep() polls a lock whose holder is
+// running before it gives up and sleeps.  A buffer or inode is
+// usually held for a few microseconds unless its holder waits
+// for the disk, and then the holder isn't running.
+#define SLEEPSPIN 4096
+
+void
+initsleeplock(struct sleeplock *lk, char *name)
+{
+  initlock(&lk->lk, "sleep lock");
+  lk->name = name;
+  lk->locked = 0;
+  lk->owner = 0;
+  lk->readers = 0;
+  lk->waiters = 0;
+  lk->xwaiters = 0;
+  lk->pid = 0;
+}
+
+// Wait for lk->locked to clear while its holder is running on
+// another cpu (it can't be running on ours: we are).  Reads
+// owner without lk->lk, which is fine for a hint: procs are
+// never freed and a stale answer only means spinning a little
+// longer or sleeping a little sooner.  The fields aren't
+// volatile, so they are read through volatile casts; pause()
+// is also a compiler barrier.
+static void
+spinwhilerunning(struct sleeplock *lk)
+{
+  struct proc *p;
+  int n;
+
+  for(n = 0; n < SLEEPSPIN && *(volatile uint*)&lk->locked; n++){
+    p = *(struct proc* volatile*)&lk->owner;
+    if(p == 0 || *(volatile enum procstate*)&p->state != RUNNING)
+      break;
+    pause();
+  }
+}
+
+// Sleep until lk may be free, lending this process's priority
+// to an exclusive holder.  Returns 1 if that holder was at a
+// lower priority.  The caller holds lk->lk.
+static int
+waitsleep(struct sleeplock *lk, int exclusive)
+{
+  int inverted;
+
+  inverted = lk->owner && inheritprio(lk->owner);
+  lk->waiters++;
+  lk->xwaiters += exclusive;
+  sleep(lk, &lk->lk);
+  lk->xwaiters -= exclusive;
+  lk->waiters--;
+  return inverted;
+}
+
+// Count a wait that began at start and was a priority inversion.
+static void
+inversion(uint start)
+{
+  proc->inversions++;
+  proc->invticks += ticks - start;
+}
+
+// Acquire lk exclusively.
+void
+acquiresleep(struct sleeplock *lk)
+{
+  int inverted;
+  uint start;
+
+  if(lk->locked)
+    spinwhilerunning(lk);
+  acquire(&lk->lk);
+  inverted = 0;
+  start = ticks;
+  while(lk->locked || lk->readers)
+    inverted |= waitsleep(lk, 1);
+  lk->locked = 1;
+  lk->owner = proc;
+  lk->pid = proc->pid;
+  release(&lk->lk);
+  proc->nsleeplocks++;
+  if(inverted)
+    inversion(start);
+}
+
+// Find lk in this process's shared holds, or a free slot if
+// lk is 0.  Only the process itself changes proc->shared.
+static struct sleeplock**
+sharedslot(struct sleeplock *lk)
+{
+  int i;
+
+  for(i = 0; i < NSHARED; i++)
+    if(proc->shared[i] == lk)
+      return &proc->shared[i];
+  return 0;
+}
+
+// Acquire lk shared.  A process must not take the same lock
+// shared twice: a writer arriving in between would deadlock.
+void
+acquiresleepshared(struct sleeplock *lk)
+{
+  struct sleeplock **slot;
+  int inverted;
+  uint start;
+
+  if(sharedslot(lk))
+    panic("acquiresleepshared");
+  if((slot = sharedslot(0)) == 0)
+    panic("acquiresleepshared: NSHARED");
+  if(lk->locked)
+    spinwhilerunning(lk);
+  acquire(&lk->lk);
+  inverted = 0;
+  start = ticks;
+  while(lk->locked || lk->xwaiters)
+    inverted |= waitsleep(lk, 0);
+  lk->readers++;
+  *slot = lk;
+  release(&lk->lk);
+  if(inverted)
+    inversion(start);
+}
+
+// Release lk, held either way.  Only wakes up (and so takes
+// ptable.lock) when the lock becomes free and someone is
+// asleep on it.  Gives back any lent priority once this
+// process holds no sleeplock exclusively.
+void
+releasesleep(struct sleeplock *lk)
+{
+  struct sleeplock **slot;
+  int exclusive;
+
+  acquire(&lk->lk);
+  exclusive = lk->locked && lk->owner == proc;
+  if(exclusive){
+    lk->locked = 0;
+    lk->owner = 0;
+    lk->pid = 0;
+  } else if((slot = sharedslot(lk)) != 0){
+    *slot = 0;
+    lk->readers--;
+  } else
+    panic("releasesleep");
+  if(lk->readers == 0 && lk->waiters)
+    wakeup(lk);
+  release(&lk->lk);
+  // The loan is kept until the last exclusive sleeplock goes,
+  // not dropped with the lock whose waiter made it: a process
+  // only records the level it was lent, not which lock or
+  // waiter it came from, and waiters lend once before they
+  // sleep rather than again later.  So if it held another lock
+  // with a waiter, dropping the loan here could leave that
+  // waiter behind a holder at the holder's own low level.
+  // Keeping the loan a little too long is the safe side.
+  // No one can lend to us once we've let go of lk->lk and hold
+  // no other sleeplock exclusively.
+  if(exclusive && --proc->nsleeplocks == 0 && proc->inherited < NLEVEL)
+    disinherit();
+}
+
+// Is lk held exclusively by this process?
+int
+holdingsleep(struct sleeplock *lk)
+{
+  int r;
+
+  acquire(&lk->lk);
+  r = lk->locked && lk->owner == proc;
+  release(&lk->lk);
+  return r;
+}
+
+// Is lk held by this process, either exclusively or shared?
+int
+holdingsleepshared(struct sleeplock *lk)
+{
+  return sharedslot(lk) != 0 || holdingsleep(lk);
+}
@@ -0,0 +1,21 @@
+// Long-term locks for processes.
+// A sleeplock may be held across disk I/O and sleep(), so it
+// can't be a spinlock.  acquiresleep() spins for a short while
+// if the holder is running on another cpu, since it is likely
+// to let go soon, and otherwise sleeps on the lock itself.
+// It can also be held shared by any number of readers at once;
+// new readers wait while a writer is waiting so that a steady
+// stream of readers can't starve it.
+struct sleeplock {
+  uint locked;        // Is the lock held exclusively?
+  struct spinlock lk; // spinlock protecting this sleep lock
+  struct proc *owner; // Process holding the lock exclusively
+  int readers;        // Processes holding the lock shared (see proc->shared)
+  int waiters;        // Processes asleep waiting for the lock
+  int xwaiters;       // Of those, how many want it exclusively
+
+  // For debugging:
+  char *name;        // Name of lock.
+  int pid;           // Process holding lock exclusively
+};
+
@@ -8,13 +8,53 @@
 #include "mmu.h"
 #include "proc.h"
 #include "spinlock.h"
+#include "lockstat.h"
+
+// Contention statistics, one entry per lock name.
+// The counters are updated by whoever holds the lock, so they
+// are exact for a lock with a name of its own and may race a
+// little between locks that share one.
+static struct lockstat lockstats[NLOCKSTAT];
+static uint lockstatbusy;  // guards adding names; see lockstatfor()
+
+// Find or add the statistics entry for name.
+// Returns 0 if the table is full.
+// initlock() runs before this cpu's cpu and ncli are set up
+// (kinit1), so this can't use acquire(); it turns interrupts
+// off and spins on lockstatbusy itself.
+static struct lockstat*
+lockstatfor(char *name)
+{
+  struct lockstat *ls;
+  uint eflags;
+
+  eflags = readeflags();
+  cli();
+  while(xchg(&lockstatbusy, 1) != 0)
+    pause();
+  for(ls = lockstats; ls < &lockstats[NLOCKSTAT]; ls++){
+    if(ls->ninit == 0)
+      safestrcpy(ls->name, name, sizeof(ls->name));
+    if(strncmp(ls->name, name, sizeof(ls->name)) == 0){
+      ls->ninit++;
+      break;
+    }
+  }
+  xchg(&lockstatbusy, 0);
+  if(eflags & FL_IF)
+    sti();
+  return ls < &lockstats[NLOCKSTAT] ? ls : 0;
+}
 
 void
 initlock(struct spinlock *lk, char *name)
 {
   lk->name = name;
+  lk->next = 0;
+  lk->owner = 0;
   lk->locked = 0;
   lk->cpu = 0;
+  lk->stat = lockstatfor(name);
 }
 
 // Acquire the lock.
@@ -24,15 +64,35 @@ initlock(struct spinlock *lk, char *name)
 void
 acquire(struct spinlock *lk)
 {
+  uint ticket;
+  uint64 spin;
+
   pushcli(); // disable interrupts to avoid deadlock.
   if(holding(lk))
     panic("acquire");
 
-  // The xchg is atomic.
+  // The locked xadd is atomic.
   // It also serializes, so that reads after acquire are not
-  // reordered before it. 
-  while(xchg(&lk->locked, 1) != 0)
-    ;
+  // reordered before it.  Waiters only read owner while they
+  // spin, so they don't bounce the cache line between them
+  // until the holder releases.
+  ticket = fetchadd(&lk->next, 1);
+  spin = 0;
+  if(lk->owner != ticket){
+    spin = rdtsc();
+    while(lk->owner != ticket)
+      pause();
+    spin = rdtsc() - spin;
+  }
+  lk->locked = 1;
+  lk->tsc = rdtsc();
+  if(lk->stat){
+    lk->stat->acquires++;
+    if(spin){
+      lk->stat->contended++;
+      lk->stat->spin += spin;
+    }
+  }
 
   // Record info about lock acquisition for debugging.
   lk->cpu = cpu;
@@ -43,26 +103,88 @@ acquire(struct spinlock *lk)
 void
 release(struct spinlock *lk)
 {
+  uint64 hold;
+
   if(!holding(lk))
     panic("release");
 
+  if(lk->stat){
+    hold = rdtsc() - lk->tsc;
+    lk->stat->hold += hold;
+    if(hold > lk->stat->maxhold)
+      lk->stat->maxhold = hold;
+  }
+
   lk->pcs[0] = 0;
   lk->cpu = 0;
+  lk->locked = 0;
 
-  // The xchg serializes, so that reads before release are 
-  // not reordered after it.  The 1996 PentiumPro manual (Volume 3,
-  // 7.2) says reads can be carried out speculatively and in
-  // any order, which implies we need to serialize here.
-  // But the 2007 Intel 64 Architecture Memory Ordering White
-  // Paper says that Intel 64 and IA-32 will not move a load
-  // after a store. So lock->locked = 0 would work here.
-  // The xchg being asm volatile ensures gcc emits it after
-  // the above assignments (and after the critical section).
-  xchg(&lk->locked, 0);
+  // Hand the lock to the next ticket.  Only the holder writes
+  // owner, so a plain increment is enough, but it must not be
+  // moved before the critical section: the 2007 Intel 64
+  // Architecture Memory Ordering White Paper says Intel 64 and
+  // IA-32 will not move a load after a store, and the barrier
+  // keeps gcc from doing so.
+  __sync_synchronize();
+  lk->owner++;
 
   popcli();
 }
 
+// Copy up to n lock statistics entries to ls and return how
+// many were copied.  If reset is set, zero the counters too.
+int
+getlockstat(struct lockstat *ls, int n, int reset)
+{
+  struct lockstat *s;
+  int i;
+
+  pushcli();
+  while(xchg(&lockstatbusy, 1) != 0)
+    pause();
+  i = 0;
+  for(s = lockstats; s < &lockstats[NLOCKSTAT] && s->ninit; s++){
+    if(i < n)
+      ls[i++] = *s;
+    if(reset){
+      s->acquires = s->contended = 0;
+      s->spin = s->hold = s->maxhold = 0;
+    }
+  }
+  xchg(&lockstatbusy, 0);
+  popcli();
+  return i;
+}
+
+// Contention microbenchmark for lockbench(): take and drop a
+// shared lock until the given number of ticks has passed and
+// return how many times this cpu got it.
+static struct spinlock benchlock;
+static volatile uint benchcount;
+
+// Give benchlock its statistics entry.  Called once at boot.
+void
+lockbenchinit(void)
+{
+  initlock(&benchlock, "lockbench");
+}
+
+int
+lockbench(int nticks)
+{
+  uint start, n;
+
+  n = 0;
+  start = ticks;
+  while(ticks - start < nticks){
+    acquire(&benchlock);
+    benchcount++;
+    release(&benchlock);
+    n++;
+  }
+  return n;
+}
+
 // Record the current call stack in pcs[] by following the %ebp chain.
 void
 getcallerpcs(void *v, uint pcs[])
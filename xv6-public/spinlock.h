@@ -1,6 +1,12 @@
 // Mutual exclusion lock.
+// A ticket lock: acquire() takes the next ticket and spins until
+// owner reaches it, so cpus get the lock in the order they asked.
 struct spinlock {
+  volatile uint next;   // Next ticket to hand out
+  volatile uint owner;  // Ticket now allowed to hold the lock
   uint locked;       // Is the lock held?
+  uint64 tsc;        // rdtsc() when it was acquired
+  struct lockstat *stat;  // Contention statistics for its name, or 0
   
   // For debugging:
   char *name;        // Name of lock.
@@ -99,6 +99,19 @@ extern int sys_wait(void);
 extern int sys_write(void);
 extern int sys_uptime(void);
 extern int sys_waitstat(void);
+extern int sys_getsched(void);
+extern int sys_setsched(void);
+extern int sys_waitstat2(void);
+extern int sys_getprocstat(void);
+extern int sys_getprocs(void);
+extern int sys_getcpustat(void);
+extern int sys_setaffinity(void);
+extern int sys_setrt(void);
+extern int sys_setpriority(void);
+extern int sys_getpriority(void);
+extern int sys_getlatency(void);
+extern int sys_lockbench(void);
+extern int sys_lockstat(void);
 
 static int (*syscalls[])(void) = {
 [SYS_fork]    sys_fork,
@@ -123,6 +136,19 @@ static int (*syscalls[])(void) = {
 [SYS_mkdir]   sys_mkdir,
 [SYS_close]   sys_close,
 [SYS_waitstat] sys_waitstat,
+[SYS_getsched] sys_getsched,
+[SYS_setsched] sys_setsched,
+[SYS_waitstat2] sys_waitstat2,
+[SYS_getprocstat] sys_getprocstat,
+[SYS_getprocs] sys_getprocs,
+[SYS_getcpustat] sys_getcpustat,
+[SYS_setaffinity] sys_setaffinity,
+[SYS_setrt]   sys_setrt,
+[SYS_setpriority] sys_setpriority,
+[SYS_getpriority] sys_getpriority,
+[SYS_getlatency] sys_getlatency,
+[SYS_lockbench] sys_lockbench,
+[SYS_lockstat] sys_lockstat,
 };
 
 void
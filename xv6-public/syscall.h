@@ -21,3 +21,16 @@
 #define SYS_mkdir  20
 #define SYS_close  21
 #define SYS_waitstat 22
+#define SYS_getsched 23
+#define SYS_setsched 24
+#define SYS_waitstat2 25
+#define SYS_getprocstat 26
+#define SYS_getprocs 27
+#define SYS_getcpustat 28
+#define SYS_setaffinity 29
+#define SYS_setrt 30
+#define SYS_setpriority 31
+#define SYS_getpriority 32
+#define SYS_getlatency 33
+#define SYS_lockbench 34
+#define SYS_lockstat 35
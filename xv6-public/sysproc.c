@@ -7,6 +7,8 @@
 #include "mmu.h"
 #include "proc.h"
 #include "spinlock.h"
+#include "sched.h"
+#include "lockstat.h"
 #include <stdio.h>
 
 struct{
@@ -109,3 +111,159 @@ int sys_waitstat(void){
 
 
 }
+
+int
+sys_getsched(void)
+{
+  struct schedparam *sp;
+
+  if(argptr(0, (void*)&sp, sizeof(*sp)) < 0)
+    return -1;
+  getsched(sp);
+  return 0;
+}
+
+int
+sys_setsched(void)
+{
+  struct schedparam *up, sp;
+
+  if(argptr(0, (void*)&up, sizeof(*up)) < 0)
+    return -1;
+  // Validate and apply a kernel copy, which the caller can't
+  // change under setsched().
+  sp = *up;
+  return setsched(&sp);
+}
+
+int
+sys_waitstat2(void)
+{
+  struct procstat *ps;
+
+  if(argptr(0, (void*)&ps, sizeof(*ps)) < 0)
+    return -1;
+  return waitstat2(ps);
+}
+
+int
+sys_getprocstat(void)
+{
+  int pid;
+  struct procstat *ps;
+
+  if(argint(0, &pid) < 0 || argptr(1, (void*)&ps, sizeof(*ps)) < 0)
+    return -1;
+  return getprocstat(pid, ps);
+}
+
+int
+sys_getprocs(void)
+{
+  int n;
+  struct procinfo *info;
+
+  if(argint(1, &n) < 0 || n < 0)
+    return -1;
+  if(n > NPROC)
+    n = NPROC;
+  if(argptr(0, (void*)&info, n*sizeof(*info)) < 0)
+    return -1;
+  return getprocs(info, n);
+}
+
+int
+sys_setaffinity(void)
+{
+  int pid, mask;
+
+  if(argint(0, &pid) < 0 || argint(1, &mask) < 0)
+    return -1;
+  return setaffinity(pid, (uint)mask);
+}
+
+int
+sys_setrt(void)
+{
+  int runtime, period, deadline;
+
+  if(argint(0, &runtime) < 0 || argint(1, &period) < 0 ||
+     argint(2, &deadline) < 0)
+    return -1;
+  return setrt(runtime, period, deadline);
+}
+
+int
+sys_setpriority(void)
+{
+  int pid, nice;
+
+  if(argint(0, &pid) < 0 || argint(1, &nice) < 0)
+    return -1;
+  return setpriority(pid, nice);
+}
+
+int
+sys_getpriority(void)
+{
+  int pid;
+
+  if(argint(0, &pid) < 0)
+    return -1;
+  return getpriority(pid);
+}
+
+int
+sys_getlatency(void)
+{
+  int n, reset;
+  struct latstat *ls;
+
+  if(argint(1, &n) < 0 || n < 0 || argint(2, &reset) < 0)
+    return -1;
+  if(n > NCPU)
+    n = NCPU;
+  if(argptr(0, (void*)&ls, n*sizeof(*ls)) < 0)
+    return -1;
+  return getlatency(ls, n, reset);
+}
+
+int
+sys_lockbench(void)
+{
+  int n;
+
+  if(argint(0, &n) < 0 || n < 1)
+    return -1;
+  return lockbench(n);
+}
+
+int
+sys_lockstat(void)
+{
+  int n, reset;
+  struct lockstat *ls;
+
+  if(argint(1, &n) < 0 || n < 0 || argint(2, &reset) < 0)
+    return -1;
+  if(n > NLOCKSTAT)
+    n = NLOCKSTAT;
+  if(argptr(0, (void*)&ls, n*sizeof(*ls)) < 0)
+    return -1;
+  return getlockstat(ls, n, reset);
+}
+
+int
+sys_getcpustat(void)
+{
+  int n;
+  struct cpustat *cs;
+
+  if(argint(1, &n) < 0 || n < 0)
+    return -1;
+  if(n > NCPU)
+    n = NCPU;
+  if(argptr(0, (void*)&cs, n*sizeof(*cs)) < 0)
+    return -1;
+  return getcpustat(cs, n);
+}
@@ -1,10 +1,11 @@
+#include "param.h"
 #include "types.h"
 #include "user.h"
+#include "sched.h"
 
 int main(int argc, char *argv[]){
 	int pid;
-	int turnaround;
-	int running;
+	struct procstat ps;
 	int i, j, k, N, C, sum, sum2;
 	int i2;
 	N = atoi(argv[1]);
@@ -30,8 +31,10 @@ int main(int argc, char *argv[]){
 			exit();
 		}else{
 			//wait();
-			waitstat(&turnaround, &running);
-			printf(1, "Turnaround: %d Running: %d\n", turnaround, running);
+			waitstat2(&ps);
+			printf(1, "Turnaround: %d Running: %d Cpu: %d Wait: %d Response: %d Migrations: %d\n",
+				ps.ended - ps.created, ps.dispatches, ps.cputicks,
+				ps.waitticks, ps.response, ps.migrations);
 			for(i2 = 1; i2 < 5*N; i2++){
 				sum2 += (1/((i2/1) + (1/j)));
 			}
@@ -1,9 +1,11 @@
+#include "param.h"
 #include "types.h"
 #include "user.h"
+#include "sched.h"
 
 int main(int argc, char *argv[]){
 	int pid;
-	int turnaround, running;
+	struct procstat ps;
 	int j;
 	int sum,k,i,C;
 	for(j = 1; j < 11; j++){
@@ -25,8 +27,10 @@ int main(int argc, char *argv[]){
 			
 			exit();
 		}else{
-			waitstat(&turnaround, &running);
-			printf(1, "parent: Turnaround: %d Running: %d\n", turnaround, running);
+			waitstat2(&ps);
+			printf(1, "parent: Turnaround: %d Running: %d Cpu: %d Wait: %d Response: %d Migrations: %d\n",
+				ps.ended - ps.created, ps.dispatches, ps.cputicks,
+				ps.waitticks, ps.response, ps.migrations);
 		}
 	}
 	exit();
@@ -0,0 +1,76 @@
+// Show the process table every few ticks.
+//   top [ticks [count]]
+// The %cpu column is the share of the last interval the
+// process spent running on some cpu.
+
+#include "param.h"
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "sched.h"
+
+static char *states[] = {
+  "unused", "embryo", "sleep ", "runble", "run   ", "zombie"
+};
+
+struct procinfo info[NPROC];
+int lastpid[NPROC];
+uint lastticks[NPROC];
+
+// Ticks pid had run at the last refresh, 0 if it is new.
+uint
+before(int pid)
+{
+  int i;
+
+  for(i = 0; i < NPROC; i++)
+    if(lastpid[i] == pid)
+      return lastticks[i];
+  return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+  int interval, count, n, i, pcpu;
+  uint now, then;
+  struct procinfo *pi;
+
+  interval = 100;
+  count = -1;
+  if(argc > 1)
+    interval = atoi(argv[1]);
+  if(argc > 2)
+    count = atoi(argv[2]);
+  if(interval < 1){
+    printf(2, "usage: top [ticks [count]]\n");
+    exit();
+  }
+
+  then = uptime();
+  for(; count != 0; count--){
+    n = getprocs(info, NPROC);
+    now = uptime();
+    printf(1, "\n%d processes at tick %d\n", n, now);
+    printf(1, "pid\tppid\tstate\tlevel\tnice\truns\tticks\t%%cpu\tcpu\tsize\tname\n");
+    for(i = 0; i < n; i++){
+      pi = &info[i];
+      pcpu = 0;
+      if(now > then)
+        pcpu = (pi->cputicks - before(pi->pid)) * 100 / (now - then);
+      printf(1, "%d\t%d\t%s\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%s\n",
+             pi->pid, pi->ppid,
+             pi->state >= 0 && pi->state < 6 ? states[pi->state] : "???",
+             pi->priority, pi->nice, pi->running, pi->cputicks, pcpu, pi->cpu,
+             pi->sz, pi->name);
+    }
+    for(i = 0; i < NPROC; i++){
+      lastpid[i] = i < n ? info[i].pid : 0;
+      lastticks[i] = i < n ? info[i].cputicks : 0;
+    }
+    then = now;
+    if(count != 1)
+      sleep(interval);
+  }
+  exit();
+}
@@ -0,0 +1,149 @@
+// Host-side decoder for tracedump output.  Reads the console
+// capture on stdin, picks out the "ev" lines, merges the cpus'
+// events by timestamp and prints a timeline with the process
+// running on each cpu, then cpu time per process.
+//   tracedecode [-m mhz] [-p pid] < console.log
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "types.h"
+#include "param.h"
+#include "sched.h"
+
+#define MAXEV  (1<<20)
+#define MAXPID 4096
+
+struct ev {
+  unsigned long long tsc;
+  int seq, cpu, type, pid, level;
+};
+
+static struct ev evs[MAXEV];
+static unsigned long long runtsc[MAXPID];
+static int dispatches[MAXPID];
+
+static char *names[] = {
+[SE_ENQUEUE]  "enqueue",
+[SE_DEQUEUE]  "dequeue",
+[SE_DISPATCH] "dispatch",
+[SE_PREEMPT]  "preempt",
+[SE_DEMOTE]   "demote",
+[SE_BOOST]    "boost",
+[SE_SLEEP]    "sleep",
+[SE_WAKEUP]   "wakeup",
+[SE_EXIT]     "exit",
+[SE_DROPPED]  "DROPPED",
+};
+
+static int
+cmp(const void *a, const void *b)
+{
+  const struct ev *x = a, *y = b;
+
+  if(x->tsc != y->tsc)
+    return x->tsc < y->tsc ? -1 : 1;
+  return x->seq - y->seq;
+}
+
+int
+main(int argc, char *argv[])
+{
+  char line[256], *s;
+  unsigned int cpu, type, pid, level, hi, lo;
+  unsigned long long start[NCPU], t0;
+  int running[NCPU];
+  int i, n, c, ncpu, mhz, only;
+  struct ev *e;
+
+  mhz = 0;
+  only = -1;
+  for(i = 1; i < argc; i++){
+    if(strcmp(argv[i], "-m") == 0 && i+1 < argc)
+      mhz = atoi(argv[++i]);
+    else if(strcmp(argv[i], "-p") == 0 && i+1 < argc)
+      only = atoi(argv[++i]);
+    else {
+      fprintf(stderr, "usage: tracedecode [-m mhz] [-p pid] < log\n");
+      exit(1);
+    }
+  }
+
+  n = 0;
+  ncpu = 0;
+  while(fgets(line, sizeof(line), stdin) && n < MAXEV){
+    if((s = strstr(line, "ev ")) == 0)
+      continue;
+    if(sscanf(s, "ev %x %x %x %x %x %x", &cpu, &type, &pid, &level,
+              &hi, &lo) != 6 || cpu >= NCPU || type > SE_DROPPED)
+      continue;
+    e = &evs[n];
+    e->tsc = (unsigned long long)hi << 32 | lo;
+    e->seq = n++;
+    e->cpu = cpu;
+    e->type = type;
+    e->pid = pid;
+    e->level = level;
+    if(cpu + 1 > ncpu)
+      ncpu = cpu + 1;
+  }
+  if(n == 0){
+    fprintf(stderr, "tracedecode: no events\n");
+    exit(1);
+  }
+  qsort(evs, n, sizeof(evs[0]), cmp);
+
+  for(c = 0; c < NCPU; c++)
+    running[c] = 0;
+  t0 = evs[0].tsc;
+  printf("%14s cpu %-8s %5s lvl |", mhz ? "usec" : "cycles", "event", "pid");
+  for(c = 0; c < ncpu; c++)
+    printf(" cpu%-3d", c);
+  printf("\n");
+  for(i = 0; i < n; i++){
+    e = &evs[i];
+    // Track what each cpu is running and charge it cpu time.
+    if(e->type == SE_DISPATCH){
+      running[e->cpu] = e->pid;
+      start[e->cpu] = e->tsc;
+      if(e->pid < MAXPID)
+        dispatches[e->pid]++;
+    } else if((e->type == SE_PREEMPT || e->type == SE_SLEEP ||
+               e->type == SE_EXIT) && running[e->cpu] == e->pid){
+      if(e->pid < MAXPID)
+        runtsc[e->pid] += e->tsc - start[e->cpu];
+      running[e->cpu] = 0;
+    }
+    if(only >= 0 && e->pid != only)
+      continue;
+    if(mhz)
+      printf("%14.1f", (double)(e->tsc - t0) / mhz);
+    else
+      printf("%14llu", e->tsc - t0);
+    printf(" %3d %-8s %5d", e->cpu, names[e->type] ? names[e->type] : "?",
+           e->pid);
+    if(e->level == NLEVEL)
+      printf("  rt |");
+    else
+      printf(" %3d |", e->level);
+    for(c = 0; c < ncpu; c++){
+      if(running[c])
+        printf(" %6d", running[c]);
+      else
+        printf(" %6s", "-");
+    }
+    printf("\n");
+  }
+
+  printf("\n%5s %10s %18s\n", "pid", "dispatch", mhz ? "usec" : "cycles");
+  for(i = 1; i < MAXPID; i++){
+    if(dispatches[i] == 0)
+      continue;
+    if(mhz)
+      printf("%5d %10d %18.1f\n", i, dispatches[i], (double)runtsc[i] / mhz);
+    else
+      printf("%5d %10d %18llu\n", i, dispatches[i], runtsc[i]);
+  }
+  return 0;
+}
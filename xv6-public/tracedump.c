@@ -0,0 +1,73 @@
+// Turn on the scheduler trace, run a command, and print the
+// events it produced on the console, one per line:
+//   ev cpu type pid level tsc-high tsc-low     (all hex)
+// Capture the console output on the host and feed it to
+// tracedecode to get a timeline.
+//   tracedump test2 5
+
+#include "param.h"
+#include "types.h"
+#include "stat.h"
+#include "user.h"
+#include "fcntl.h"
+#include "sched.h"
+
+struct schedevent ev[64];
+
+// Print whatever is in the trace rings now.
+void
+drain(int fd)
+{
+  int i, n;
+  struct schedevent *e;
+
+  while((n = read(fd, ev, sizeof(ev))) > 0){
+    for(i = 0; i < n / sizeof(ev[0]); i++){
+      e = &ev[i];
+      printf(1, "ev %x %x %x %x %x %x\n", e->cpu, e->type, e->pid,
+             e->level, (uint)(e->tsc >> 32), (uint)e->tsc);
+    }
+  }
+}
+
+int
+main(int argc, char *argv[])
+{
+  struct procstat ps;
+  int fd, pid;
+
+  if(argc < 2){
+    printf(2, "usage: tracedump command [args...]\n");
+    exit();
+  }
+  if((fd = open("/schedtrace", O_RDWR)) < 0){
+    printf(2, "tracedump: cannot open /schedtrace\n");
+    exit();
+  }
+  write(fd, "0", 1);
+  while(read(fd, ev, sizeof(ev)) > 0)
+    ;
+  write(fd, "1", 1);
+
+  pid = fork();
+  if(pid < 0){
+    printf(2, "tracedump: fork failed\n");
+    exit();
+  }
+  if(pid == 0){
+    exec(argv[1], argv+1);
+    printf(2, "tracedump: exec %s failed\n", argv[1]);
+    exit();
+  }
+
+  // Drain while the command runs so the rings don't fill.
+  while(getprocstat(pid, &ps) == 0 && ps.ended == 0){
+    drain(fd);
+    sleep(1);
+  }
+  wait();
+  write(fd, "0", 1);
+  drain(fd);
+  close(fd);
+  exit();
+}
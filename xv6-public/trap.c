@@ -57,7 +57,18 @@ trap(struct trapframe *tf)
       ticks++;
       wakeup(&ticks);
       release(&tickslock);
+      rtwakeup();
     }
+    if(cpu->idle)
+      cpu->idleticks++;
+    else
+      cpu->busyticks++;
+    lapiceoi();
+    break;
+  case T_IRQ0 + IRQ_RESCHED:
+    // Another cpu queued work while we were halted in
+    // scheduler(), or released a real-time job for this
+    // cpu; see the preemption check below.
     lapiceoi();
     break;
   case T_IRQ0 + IRQ_IDE:
@@ -104,12 +115,20 @@ trap(struct trapframe *tf)
   if(proc && proc->killed && (tf->cs&3) == DPL_USER)
     exit();
 
-  // Force process to give up CPU on clock tick.
+  // Force process to give up CPU once its time slice is used up.
   // If interrupts were on while locks held, would need to check nlock.
   if(proc && proc->state == RUNNING && tf->trapno == T_IRQ0+IRQ_TIMER){	  
-    yield();
+    proc->cputicks++;
+    proc->levelticks[proc->priority]++;
+    if(schedtick(proc))
+      yield();
   }
 
+  // A real-time job released for this cpu by rtwakeup().
+  if(proc && proc->state == RUNNING && tf->trapno == T_IRQ0+IRQ_RESCHED &&
+     rtpreempt(proc))
+    yield();
+
 
 
   // Check if the process has been killed since we yielded
@@ -1,5 +1,11 @@
 struct stat;
 struct rtcdate;
+struct schedparam;
+struct procstat;
+struct procinfo;
+struct cpustat;
+struct latstat;
+struct lockstat;
 
 // system calls
 int fork(void);
@@ -24,6 +30,19 @@ char* sbrk(int);
 int sleep(int);
 int uptime(void);
 int waitstat(int*, int*);
+int getsched(struct schedparam*);
+int setsched(struct schedparam*);
+int waitstat2(struct procstat*);
+int getprocstat(int, struct procstat*);
+int getprocs(struct procinfo*, int);
+int getcpustat(struct cpustat*, int);
+int setaffinity(int, uint);
+int setrt(int, int, int);
+int setpriority(int, int);
+int getpriority(int);
+int getlatency(struct latstat*, int, int);
+int lockbench(int);
+int lockstat(struct lockstat*, int, int);
 
 // ulib.c
 int stat(char*, struct stat*);
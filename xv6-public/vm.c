@@ -111,17 +111,19 @@ mappages(pde_t *pgdir, void *va, uint size, uint pa, int perm)
 // (directly addressable from end..P2V(PHYSTOP)).
 
 // This table defines the kernel's mappings, which are present in
-// every process's page table.
+// every process's page table.  They are the same in every page
+// table and never change, so they are marked global: with
+// CR4.PGE on (entry.S) they stay in the TLB across cr3 loads.
 static struct kmap {
   void *virt;
   uint phys_start;
   uint phys_end;
   int perm;
 } kmap[] = {
- { (void*)KERNBASE, 0,             EXTMEM,    PTE_W}, // I/O space
- { (void*)KERNLINK, V2P(KERNLINK), V2P(data), 0},     // kern text+rodata
- { (void*)data,     V2P(data),     PHYSTOP,   PTE_W}, // kern data+memory
- { (void*)DEVSPACE, DEVSPACE,      0,         PTE_W}, // more devices
+ { (void*)KERNBASE, 0,             EXTMEM,    PTE_W|PTE_G}, // I/O space
+ { (void*)KERNLINK, V2P(KERNLINK), V2P(data), PTE_G},     // kern text+rodata
+ { (void*)data,     V2P(data),     PHYSTOP,   PTE_W|PTE_G}, // kern data+memory
+ { (void*)DEVSPACE, DEVSPACE,      0,         PTE_W|PTE_G}, // more devices
 };
 
 // Set up kernel part of a page table.
@@ -149,7 +151,25 @@ void
 kvmalloc(void)
 {
   kpgdir = setupkvm();
-  switchkvm();
+  // Not switchkvm(): cpu isn't set up yet.
+  lcr3(v2p(kpgdir));
+}
+
+// Load pgdir into cr3 unless this cpu already has it loaded.
+// A cr3 load flushes the TLB's user entries; kernel entries
+// are global and survive it.
+// Every cpu has either kpgdir or its current process's page
+// table loaded, so a page table can't be freed while loaded.
+static void
+loadpgdir(pde_t *pgdir)
+{
+  if(cpu->pgdir == pgdir){
+    cpu->cr3skips++;
+    return;
+  }
+  cpu->pgdir = pgdir;
+  cpu->cr3loads++;
+  lcr3(v2p(pgdir));
 }
 
 // Switch h/w page table register to the kernel-only page table,
@@ -157,7 +177,9 @@ kvmalloc(void)
 void
 switchkvm(void)
 {
-  lcr3(v2p(kpgdir));   // switch to the kernel page table
+  pushcli();
+  loadpgdir(kpgdir);   // switch to the kernel page table
+  popcli();
 }
 
 // Switch TSS and h/w page table to correspond to process p.
@@ -172,7 +194,21 @@ switchuvm(struct proc *p)
   ltr(SEG_TSS << 3);
   if(p->pgdir == 0)
     panic("switchuvm: no pgdir");
-  lcr3(v2p(p->pgdir));  // switch to new address space
+  loadpgdir(p->pgdir);  // switch to new address space
+  popcli();
+}
+
+// Flush this cpu's TLB entries for p's user memory after
+// changing p's page table in place.  switchuvm() won't, since
+// the page table is already loaded.
+void
+flushuvm(struct proc *p)
+{
+  pushcli();
+  if(cpu->pgdir != p->pgdir)
+    panic("flushuvm");
+  cpu->cr3loads++;
+  lcr3(v2p(p->pgdir));
   popcli();
 }
 
@@ -117,6 +117,15 @@ sti(void)
   asm volatile("sti");
 }
 
+// Enable interrupts and halt until the next one arrives.
+// sti takes effect only after the next instruction, so an
+// interrupt can't be taken between the sti and the hlt.
+static inline void
+stihlt(void)
+{
+  asm volatile("sti; hlt");
+}
+
 static inline uint
 xchg(volatile uint *addr, uint newval)
 {
@@ -130,6 +139,53 @@ xchg(volatile uint *addr, uint newval)
   return result;
 }
 
+// Atomically add v to *addr and return the old value.
+static inline uint
+fetchadd(volatile uint *addr, uint v)
+{
+  asm volatile("lock; xaddl %0, %1" :
+               "+r" (v), "+m" (*addr) :
+               :
+               "memory", "cc");
+  return v;
+}
+
+// Tell the cpu we are in a spin-wait loop.
+// The "memory" clobber makes it a compiler barrier, so a loop
+// around it reloads whatever it is waiting on.
+static inline void
+pause(void)
+{
+  asm volatile("pause" : : : "memory");
+}
+
+// Index of the least significant set bit; x must be non-zero.
+static inline uint
+bsf(uint x)
+{
+  uint r;
+  asm volatile("bsfl %1,%0" : "=r" (r) : "rm" (x) : "cc");
+  return r;
+}
+
+// Index of the most significant set bit; x must be non-zero.
+static inline uint
+bsr(uint x)
+{
+  uint r;
+  asm volatile("bsrl %1,%0" : "=r" (r) : "rm" (x) : "cc");
+  return r;
+}
+
+// Cycles since reset, from the time-stamp counter.
+static inline uint64
+rdtsc(void)
+{
+  uint64 val;
+  asm volatile("rdtsc" : "=A" (val));
+  return val;
+}
+
 static inline uint
 rcr2(void)
 {